@@ -11,6 +11,7 @@
 #include <opm/core/grid/GridManager.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 #include "equelle/EquelleRuntimeCPU.hpp"
+#include "equelle/FieldFile.hpp"
 #include "equelle/mpiutils.hpp"
 #include "equelle/SubGridBuilder.hpp"
 
@@ -93,6 +94,8 @@ void RuntimeMPI::decompose()
     subGrid = SubGridBuilder::build( globalGrid->c_grid(), localCells );
 
     runtime.reset( new EquelleRuntimeCPU( subGrid.c_grid, param_ ) );
+    // Outputs are gathered to the global grid on rank 0.
+    runtime->outputWriter().setGrid( *globalGrid->c_grid() );
 
     auto endTime = MPI_Wtime();
 
@@ -177,6 +180,26 @@ CollOfScalar RuntimeMPI::inputCollectionOfScalar(const String &name, const CollO
     const bool from_file = param_.getDefault(name + "_from_file", false);
     if (from_file) {
         const String filename = param_.get<String>(name + "_filename");
+
+        if (isBinaryInput(param_.getDefault<String>(name + "_format", "auto"), filename)) {
+            const FieldFile file(filename);
+            if (file.size() != globalGrid->c_grid()->number_of_cells) {
+                OPM_THROW(std::runtime_error, "Unexpected size of input data for " << name << " in file " << filename);
+            }
+            if (file.entity() != FieldEntity::None && file.entity() != FieldEntity::Cells) {
+                OPM_THROW(std::runtime_error, "Input data for " << name << " in file " << filename << " is for faces.");
+            }
+            // Only the pages holding our cells are read from the mapping,
+            // straight into the result.
+            CollOfScalar::V data( size );
+            for( int i = 0; i < size; ++i ) {
+                data[i] = file.value( subGrid.cell_local_to_global[i] );
+            }
+            return CollOfScalar( std::move( data ) );
+        }
+
+        std::vector<double> localData( coll.size() );
+
         std::ifstream is(filename.c_str());
         if (!is) {
             OPM_THROW(std::runtime_error, "Could not find file " << filename);
@@ -185,8 +208,6 @@ CollOfScalar RuntimeMPI::inputCollectionOfScalar(const String &name, const CollO
         std::istream_iterator<double> end;
         std::vector<double> data(beg, end);
 
-        std::vector<double> localData( coll.size() );
-
         // Map into local cell enumeration
         for( int i = 0; i < coll.size(); ++i ) {
             auto glob = subGrid.cell_local_to_global[i];
@@ -214,21 +235,22 @@ CollOfFace RuntimeMPI::inputDomainSubsetOf(const String &name, const CollOfFace
     std::istream_iterator<int> beg(is);
     std::istream_iterator<int> end;
 
-    CollOfFace data;
+    std::vector<Face> entities;
     for (auto it = beg; it != end; ++it) {
         logstream << "Read " << *it << std::endl;
         auto jt = subGrid.face_global_to_local.find( *it );
         if ( jt != subGrid.face_global_to_local.end() ) { // This face is part of our domain
-            data.emplace_back( jt->second );
+            entities.emplace_back( jt->second );
 
             logstream << "Adding " << *it << " -> " << jt->second << std::endl;
         } // else the face is not part of our domain
     }
 
     // Needed to allow for std::includes to give valid results.
-    std::sort( data.begin(), data.end() );
+    std::sort( entities.begin(), entities.end() );
+    CollOfFace data( std::move( entities ) );
 
-    if (!includes(superset.begin(), superset.end(), data.begin(), data.end())) {
+    if (!std::includes(superset.begin(), superset.end(), data.begin(), data.end())) {
         logstream << "Rank: " << equelle::getMPIRank() << " is throwing." << std::endl;
         OPM_THROW(std::runtime_error, "Given faces are not in the assumed subset.");
     }
@@ -248,21 +270,22 @@ CollOfCell RuntimeMPI::inputDomainSubsetOf(const String &name, const CollOfCell
     std::istream_iterator<int> beg(is);
     std::istream_iterator<int> end;
 
-    CollOfCell data;
+    std::vector<Cell> entities;
     for (auto it = beg; it != end; ++it) {
         logstream << "Read " << *it << std::endl;
         auto jt = subGrid.cell_global_to_local.find( *it );
         if ( jt != subGrid.cell_global_to_local.end() ) { // This cell is part of our domain
-            data.emplace_back( jt->second );
+            entities.emplace_back( jt->second );
 
             logstream << "Adding " << *it << " -> " << jt->second << std::endl;
         } // else the cell is not part of our domain
     }
 
     // Needed to allow for std::includes to give valid results.
-    std::sort( data.begin(), data.end() );
+    std::sort( entities.begin(), entities.end() );
+    CollOfCell data( std::move( entities ) );
 
-    if (!includes(superset.begin(), superset.end(), data.begin(), data.end())) {
+    if (!std::includes(superset.begin(), superset.end(), data.begin(), data.end())) {
         logstream << "Rank: " << equelle::getMPIRank() << " is throwing." << std::endl;
         OPM_THROW(std::runtime_error, "Given cells are not in the assumed subset.");
     }
@@ -278,9 +301,16 @@ Scalar RuntimeMPI::inputScalarWithDefault(const String &name, const Scalar defau
 
 void RuntimeMPI::output(const String &tag, const CollOfScalar &vals)
 {
+    // Skipped outputs skip the gather too. Rank 0 decides, since the
+    // output_time_interval clocks of the nodes differ.
+    int step = runtime->outputWriter().nextStep( tag );
+    MPI_SAFE_CALL( MPI_Bcast( &step, 1, MPI_INT, 0, MPI_COMM_WORLD ) );
+    if ( step < 0 ) {
+        return;
+    }
     auto val = allGather( vals );
     if ( equelle::getMPIRank() == 0 ) {
-        runtime->output( tag, val );
+        runtime->output( tag, step, CollOfScalarValue( val ) );
     }
 }
 
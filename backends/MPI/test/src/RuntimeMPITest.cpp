@@ -3,6 +3,7 @@
 #include <boost/test/unit_test.hpp>
 #include "equelle/RuntimeMPI.hpp"
 #include "equelle/EquelleRuntimeCPU.hpp"
+#include "equelle/FieldFile.hpp"
 #include "equelle/mpiutils.hpp"
 
 using namespace equelle;
@@ -39,6 +40,39 @@ BOOST_AUTO_TEST_CASE( allGather ) {
 }
 
 
+BOOST_AUTO_TEST_CASE( inputCollectionOfScalar_binary ) {
+    Opm::parameter::ParameterGroup param;
+    param.disableOutput();
+
+    // These are global input data.
+    // Rely on default grid being 6x1
+    std::vector<double> a_0 = { 0, 1.5, 2, 3, 4, 5.25 };
+    if ( equelle::getMPIRank() == 0 ) {
+        FieldFile::write( "a.eqf", a_0.data(), a_0.size(), FieldEntity::Cells );
+        FieldFile::write( "b.eqf", a_0.data(), a_0.size(), FieldEntity::Faces );
+        FieldFile::write( "c.eqf", a_0.data(), a_0.size() - 1, FieldEntity::Cells );
+    }
+    MPI_SAFE_CALL( MPI_Barrier( MPI_COMM_WORLD ) );
+    for( const std::string name: { "a", "b", "c" } ) {
+        param.insertParameter( name + "_from_file", "true" );
+        param.insertParameter( name + "_filename", name + ".eqf" );
+    }
+
+    equelle::RuntimeMPI er( param );
+    er.decompose();
+
+    // Each node gets the values of its cells, ghost cells included.
+    const CollOfScalar a = er.inputCollectionOfScalar("a", er.allCells());
+    BOOST_REQUIRE_EQUAL( a.size(), er.subGrid.c_grid->number_of_cells );
+    for( int i = 0; i < a.size(); ++i ) {
+        BOOST_CHECK_EQUAL( a.value()[i], a_0[ er.subGrid.cell_local_to_global[i] ] );
+    }
+
+    // Face data and data of the wrong size are rejected.
+    BOOST_CHECK_THROW( er.inputCollectionOfScalar("b", er.allCells()), std::runtime_error );
+    BOOST_CHECK_THROW( er.inputCollectionOfScalar("c", er.allCells()), std::runtime_error );
+}
+
 BOOST_AUTO_TEST_CASE( inputScalarWithDefault ) {
     Opm::parameter::ParameterGroup param;
 
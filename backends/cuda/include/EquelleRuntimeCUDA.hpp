@@ -244,10 +244,12 @@ public:
       Let rescomp be the a residual function taking the primary variable as input.
       The function uses a Newton method to find (and return) the CollOfScalar u such that
       resomp(u) = 0, where u_initialguess is the initial guess. 
+      The call site number given by the compiler is not used.
      */
     template <class ResidualFunctor> 
     CollOfScalar newtonSolve(const ResidualFunctor& rescomp,
-			     const CollOfScalar& u_initialguess);
+			     const CollOfScalar& u_initialguess,
+			     const int site = 0);
     
     //    template <int Num>
     //    std::array<CollOfScalarCPU, Num> newtonSolveSystem(const std::array<typename ResCompType<Num>::type, Num>& rescomp,
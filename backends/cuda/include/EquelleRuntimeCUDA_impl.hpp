@@ -215,7 +215,8 @@ CollOfVector EquelleRuntimeCUDA::centroid( const CollOfIndices<codim>& set) cons
 
 template <class ResidualFunctor>
 CollOfScalar EquelleRuntimeCUDA::newtonSolve(const ResidualFunctor& rescomp,
-                                            const CollOfScalar& u_initialguess)
+                                            const CollOfScalar& u_initialguess,
+                                            const int /*site*/)
 {
     Opm::time::StopWatch clock;
     clock.start();
@@ -0,0 +1,415 @@
+/*
+  Copyright 2013 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <Eigen/Sparse>
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <utility>
+#include <cassert>
+
+#include "equelle/equelleTypes.hpp"
+
+namespace equelle {
+
+/// Kernels operating directly on the values and jacobian blocks of
+/// CollOfScalar objects. They replace the generic approach of building
+/// a sparse matrix for an operation and multiplying it into every block.
+
+/// The sparse format the kernels work on. This is the storage format
+/// used by the AutoDiffBlock jacobians, so conversions are cheap.
+typedef Eigen::SparseMatrix<double> SparseColMajor;
+
+
+/// Sort the entries of each column by row index. Kernels that create
+/// entries out of order call this before returning a matrix.
+inline void sortColumns(SparseColMajor& s)
+{
+    const int cols = s.cols();
+    const int* outer = s.outerIndexPtr();
+    int* inner = s.innerIndexPtr();
+    double* val = s.valuePtr();
+    std::vector<std::pair<int, double>> entries;
+    for (int c = 0; c < cols; ++c) {
+        const int beg = outer[c];
+        const int end = outer[c + 1];
+        if (std::is_sorted(inner + beg, inner + end)) {
+            continue;
+        }
+        entries.clear();
+        for (int k = beg; k < end; ++k) {
+            entries.emplace_back(inner[k], val[k]);
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const std::pair<int, double>& a, const std::pair<int, double>& b) { return a.first < b.first; });
+        for (int k = beg; k < end; ++k) {
+            inner[k] = entries[k - beg].first;
+            val[k] = entries[k - beg].second;
+        }
+    }
+}
+
+
+/// Returns true if the indices are in non-decreasing order.
+template <class IntVec>
+bool isNonDecreasing(const IntVec& indices)
+{
+    const int n = indices.size();
+    for (int i = 1; i < n; ++i) {
+        if (indices[i] < indices[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Row gather: row i of the result is row indices[i] of m.
+/// Indices may be repeated.
+template <class IntVec>
+CollOfScalar::M gatherRows(const CollOfScalar::M& m, const IntVec& indices)
+{
+    SparseColMajor s;
+    m.toSparse(s);
+    s.makeCompressed();
+    const int n = indices.size();
+    const int rows = s.rows();
+    const int cols = s.cols();
+
+    // For each source row, the (ascending) output rows that take it.
+    std::vector<int> inv_start(rows + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        assert(indices[i] >= 0 && indices[i] < rows);
+        ++inv_start[indices[i] + 1];
+    }
+    std::partial_sum(inv_start.begin(), inv_start.end(), inv_start.begin());
+    std::vector<int> inv(n);
+    {
+        std::vector<int> cursor(inv_start.begin(), inv_start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            inv[cursor[indices[i]]++] = i;
+        }
+    }
+
+    // Count and fill the result columns.
+    const int* outer = s.outerIndexPtr();
+    const int* inner = s.innerIndexPtr();
+    const double* val = s.valuePtr();
+    SparseColMajor r(n, cols);
+    int* r_outer = r.outerIndexPtr();
+    r_outer[0] = 0;
+    for (int c = 0; c < cols; ++c) {
+        int count = 0;
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            count += inv_start[inner[k] + 1] - inv_start[inner[k]];
+        }
+        r_outer[c + 1] = r_outer[c] + count;
+    }
+    r.resizeNonZeros(r_outer[cols]);
+    int* r_inner = r.innerIndexPtr();
+    double* r_val = r.valuePtr();
+    for (int c = 0; c < cols; ++c) {
+        int pos = r_outer[c];
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            for (int j = inv_start[inner[k]]; j < inv_start[inner[k] + 1]; ++j) {
+                r_inner[pos] = inv[j];
+                r_val[pos] = val[k];
+                ++pos;
+            }
+        }
+    }
+    // Monotone indices keep the entries of each column in order.
+    if (!isNonDecreasing(indices)) {
+        sortColumns(r);
+    }
+    return CollOfScalar::M(std::move(r));
+}
+
+
+/// Row scatter: row i of m becomes row indices[i] of the n-row result.
+/// Other rows of the result are empty. Indices must be distinct.
+template <class IntVec>
+CollOfScalar::M scatterRows(const CollOfScalar::M& m, const IntVec& indices, const int n)
+{
+    SparseColMajor s;
+    m.toSparse(s);
+    s.makeCompressed();
+    assert(int(indices.size()) == s.rows());
+    // Same structure as the input, only the row indices change.
+    const int nnz = s.nonZeros();
+    int* inner = s.innerIndexPtr();
+    for (int k = 0; k < nnz; ++k) {
+        inner[k] = indices[inner[k]];
+    }
+    s.conservativeResize(n, s.cols());
+    if (!isNonDecreasing(indices)) {
+        sortColumns(s);
+    }
+    return CollOfScalar::M(std::move(s));
+}
+
+
+/// Row select: row i of the result is row i of iftrue if predicate[i]
+/// is true, and row i of iffalse otherwise. The result has the union of
+/// the sparsity patterns of iftrue and iffalse, with explicit zeros
+/// where the selected side has no entry, so the pattern does not depend
+/// on the predicate and stays the same over Newton iterations.
+inline CollOfScalar::M selectRows(const CollOfBool& predicate,
+                                  const CollOfScalar::M& iftrue,
+                                  const CollOfScalar::M& iffalse)
+{
+    SparseColMajor t;
+    SparseColMajor f;
+    iftrue.toSparse(t);
+    iffalse.toSparse(f);
+    t.makeCompressed();
+    f.makeCompressed();
+    const int rows = predicate.size();
+    const int cols = t.cols();
+    assert(t.rows() == rows && f.rows() == rows && f.cols() == cols);
+    const int* t_outer = t.outerIndexPtr();
+    const int* t_inner = t.innerIndexPtr();
+    const double* t_val = t.valuePtr();
+    const int* f_outer = f.outerIndexPtr();
+    const int* f_inner = f.innerIndexPtr();
+    const double* f_val = f.valuePtr();
+
+    // Count the rows of the union of each column, both sides are sorted
+    // by row.
+    SparseColMajor r(rows, cols);
+    int* r_outer = r.outerIndexPtr();
+    r_outer[0] = 0;
+    for (int c = 0; c < cols; ++c) {
+        int count = 0;
+        int kt = t_outer[c];
+        int kf = f_outer[c];
+        while (kt < t_outer[c + 1] || kf < f_outer[c + 1]) {
+            const int row_t = kt < t_outer[c + 1] ? t_inner[kt] : rows;
+            const int row_f = kf < f_outer[c + 1] ? f_inner[kf] : rows;
+            const int row = std::min(row_t, row_f);
+            kt += (row_t == row);
+            kf += (row_f == row);
+            ++count;
+        }
+        r_outer[c + 1] = r_outer[c] + count;
+    }
+    r.resizeNonZeros(r_outer[cols]);
+
+    // Merge, taking the value of the selected side, or zero.
+    int* r_inner = r.innerIndexPtr();
+    double* r_val = r.valuePtr();
+    for (int c = 0; c < cols; ++c) {
+        int pos = r_outer[c];
+        int kt = t_outer[c];
+        int kf = f_outer[c];
+        while (kt < t_outer[c + 1] || kf < f_outer[c + 1]) {
+            const int row_t = kt < t_outer[c + 1] ? t_inner[kt] : rows;
+            const int row_f = kf < f_outer[c + 1] ? f_inner[kf] : rows;
+            const int row = std::min(row_t, row_f);
+            r_inner[pos] = row;
+            if (predicate[row]) {
+                r_val[pos] = row_t == row ? t_val[kt] : 0.0;
+            } else {
+                r_val[pos] = row_f == row ? f_val[kf] : 0.0;
+            }
+            ++pos;
+            kt += (row_t == row);
+            kf += (row_f == row);
+        }
+        assert(pos == r_outer[c + 1]);
+    }
+    return CollOfScalar::M(std::move(r));
+}
+
+
+/// Returns the elements of x at the given indices, with jacobians.
+template <class IntVec>
+CollOfScalar gather(const CollOfScalar::ADB& x, const IntVec& indices)
+{
+    const int n = indices.size();
+    const CollOfScalar::V& xv = x.value();
+    CollOfScalar::V val(n);
+    for (int i = 0; i < n; ++i) {
+        val[i] = xv[indices[i]];
+    }
+    const auto& xjac = x.derivative();
+    if (xjac.empty()) {
+        return CollOfScalar(val);
+    }
+    const int num_blocks = xjac.size();
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        jac[block] = gatherRows(xjac[block], indices);
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+
+/// Returns a collection of size n that is zero except at the given
+/// indices, where the elements of x are placed, with jacobians.
+template <class IntVec>
+CollOfScalar scatter(const CollOfScalar::ADB& x, const IntVec& indices, const int n)
+{
+    const int sz = indices.size();
+    assert(sz == x.size());
+    const CollOfScalar::V& xv = x.value();
+    CollOfScalar::V val = CollOfScalar::V::Zero(n);
+    for (int i = 0; i < sz; ++i) {
+        val[indices[i]] = xv[i];
+    }
+    const auto& xjac = x.derivative();
+    if (xjac.empty()) {
+        return CollOfScalar(val);
+    }
+    const int num_blocks = xjac.size();
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        jac[block] = scatterRows(xjac[block], indices, n);
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+/// Returns iftrue where predicate is true and iffalse elsewhere, with
+/// jacobians. Both the values and the jacobian rows are picked directly,
+/// instead of being multiplied by 0/1 masks.
+inline CollOfScalar select(const CollOfBool& predicate,
+                           const CollOfScalar::ADB& iftrue,
+                           const CollOfScalar::ADB& iffalse)
+{
+    const int sz = predicate.size();
+    assert(sz == iftrue.size() && sz == iffalse.size());
+    CollOfScalar::V val = predicate.select(iftrue.value(), iffalse.value());
+    const auto& tjac = iftrue.derivative();
+    const auto& fjac = iffalse.derivative();
+    if (tjac.empty() && fjac.empty()) {
+        return CollOfScalar(val);
+    }
+    // A side without jacobians is constant, its rows are zero.
+    const auto& some_jac = tjac.empty() ? fjac : tjac;
+    const int num_blocks = some_jac.size();
+    assert(tjac.empty() || fjac.empty() || int(fjac.size()) == num_blocks);
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        const int cols = some_jac[block].cols();
+        jac[block] = selectRows(predicate,
+                                tjac.empty() ? CollOfScalar::M(sz, cols) : tjac[block],
+                                fjac.empty() ? CollOfScalar::M(sz, cols) : fjac[block]);
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+
+/// A linear map y = S x given by its transpose: each row r of x adds
+/// weight[k] times itself to row target[k] of y, for start[r] <= k <
+/// start[r + 1]. The targets of each row are sorted. Used for the
+/// gradients and divergences, where the rows of x are cells or faces and
+/// the targets their neighbouring faces or cells.
+struct RowStencil
+{
+    int rows;
+    std::vector<int> start;
+    std::vector<int> target;
+    std::vector<double> weight;
+};
+
+
+/// Returns S m for the stencil S, column by column, without forming S.
+CollOfScalar::M stencilRows(const CollOfScalar::M& m, const RowStencil& st);
+
+
+/// Returns S x for the stencil S, with jacobians.
+CollOfScalar applyStencil(const CollOfScalar::ADB& x, const RowStencil& st);
+
+
+/// Returns diag(d) m, row i of m scaled by d[i], with the pattern of m.
+CollOfScalar::M scaleRows(const CollOfScalar::V& d, const CollOfScalar::M& m);
+
+
+/// Returns diag(a) ma + diag(b) mb, with the union of the patterns of ma
+/// and mb. Entries in both are summed in that order, as in the sum of
+/// the two products.
+CollOfScalar::M scaleRowsSum(const CollOfScalar::V& a, const CollOfScalar::M& ma,
+                             const CollOfScalar::V& b, const CollOfScalar::M& mb);
+
+
+/// Assembles the residuals of a system of equations into one vector and
+/// one matrix. The rows of residual i follow those of residuals 0..i-1,
+/// and the columns of jacobian block j (unknown j, with block_pattern[j]
+/// columns) follow those of blocks 0..j-1. Residuals without jacobians
+/// contribute zero blocks. The storage of value and jacobian is reused.
+inline void assembleSystem(const std::vector<CollOfScalar>& residuals,
+                           const std::vector<int>& block_pattern,
+                           CollOfScalar::V& value,
+                           SparseColMajor& jacobian)
+{
+    const int num_eq = residuals.size();
+    const int num_blocks = block_pattern.size();
+    if (num_eq == 1 && num_blocks == 1 && !residuals[0].derivative().empty()) {
+        // Nothing to assemble.
+        value = residuals[0].value();
+        residuals[0].derivative()[0].toSparse(jacobian);
+        jacobian.makeCompressed();
+        return;
+    }
+
+    std::vector<int> row_start(num_eq + 1, 0);
+    for (int eq = 0; eq < num_eq; ++eq) {
+        row_start[eq + 1] = row_start[eq] + residuals[eq].size();
+    }
+    const int rows = row_start[num_eq];
+    const int cols = std::accumulate(block_pattern.begin(), block_pattern.end(), 0);
+    value.resize(rows);
+    for (int eq = 0; eq < num_eq; ++eq) {
+        value.segment(row_start[eq], residuals[eq].size()) = residuals[eq].value();
+    }
+
+    // Compressed column major copies of the blocks.
+    std::vector<SparseColMajor> blocks(num_eq * num_blocks);
+    int nnz = 0;
+    for (int eq = 0; eq < num_eq; ++eq) {
+        const auto& jac = residuals[eq].derivative();
+        assert(jac.empty() || int(jac.size()) == num_blocks);
+        for (int block = 0; block < num_blocks; ++block) {
+            SparseColMajor& b = blocks[eq * num_blocks + block];
+            if (jac.empty()) {
+                b.resize(residuals[eq].size(), block_pattern[block]);
+            } else {
+                jac[block].toSparse(b);
+            }
+            b.makeCompressed();
+            assert(b.cols() == block_pattern[block]);
+            nnz += b.nonZeros();
+        }
+    }
+
+    // Each global column is the concatenation of the matching columns
+    // of the blocks above each other, so its entries stay sorted.
+    jacobian.resize(rows, cols);
+    jacobian.resizeNonZeros(nnz);
+    int* outer = jacobian.outerIndexPtr();
+    int* inner = jacobian.innerIndexPtr();
+    double* val = jacobian.valuePtr();
+    int col = 0;
+    int pos = 0;
+    for (int block = 0; block < num_blocks; ++block) {
+        for (int c = 0; c < block_pattern[block]; ++c, ++col) {
+            outer[col] = pos;
+            for (int eq = 0; eq < num_eq; ++eq) {
+                const SparseColMajor& b = blocks[eq * num_blocks + block];
+                for (int k = b.outerIndexPtr()[c]; k < b.outerIndexPtr()[c + 1]; ++k) {
+                    inner[pos] = b.innerIndexPtr()[k] + row_start[eq];
+                    val[pos] = b.valuePtr()[k];
+                    ++pos;
+                }
+            }
+        }
+    }
+    outer[cols] = pos;
+}
+
+
+} // namespace equelle
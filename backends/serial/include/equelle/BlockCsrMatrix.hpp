@@ -0,0 +1,72 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "equelle/AutoDiffKernels.hpp"
+
+namespace equelle {
+
+/// A square sparse matrix of dense blocks in block compressed row
+/// storage (BSR). Each block is block_size x block_size, stored row major.
+///
+/// The jacobians of systems are assembled with the unknowns one after
+/// the other: element e of unknown j is column j*n + e, and element e of
+/// equation i is row i*n + e. The block matrix interleaves them, so that
+/// block (e, f) holds the derivatives of all equations of element e by
+/// all unknowns of element f. Vectors must be interleaved the same way,
+/// see toBlockOrder() and fromBlockOrder().
+class BlockCsrMatrix
+{
+public:
+    BlockCsrMatrix();
+
+    /// Sets up the block pattern for the matrix m, and the positions of
+    /// its entries in the block values. All diagonal blocks are stored.
+    void setPattern(const SparseColMajor& m, const int block_size);
+
+    /// Copies the values of m, which must have the pattern given to the
+    /// last call to setPattern().
+    void setValues(const SparseColMajor& m);
+
+    /// Takes the block arrays directly, swapping them into the matrix.
+    /// The column indices of each row must be sorted, and all diagonal
+    /// blocks present. A matrix set up this way cannot be refilled with
+    /// setValues().
+    void setBlocks(const int block_size,
+                   std::vector<int>& row_start,
+                   std::vector<int>& col_index,
+                   std::vector<double>& values);
+
+    int blockSize() const;
+    int blockRows() const;
+    const std::vector<int>& rowStart() const;
+    const std::vector<int>& colIndex() const;
+    /// Position of the diagonal block of each block row.
+    const std::vector<int>& diagonal() const;
+    const std::vector<double>& values() const;
+
+    /// y = A x, with x and y in block order.
+    void multiply(const double* x, double* y) const;
+
+    /// Interleaves x, ordered by unknown, into z, ordered by element.
+    void toBlockOrder(const double* x, double* z) const;
+
+    /// Inverse of toBlockOrder().
+    void fromBlockOrder(const double* z, double* x) const;
+
+private:
+    int block_size_;
+    int block_rows_;
+    std::vector<int> row_start_;
+    std::vector<int> col_index_;
+    std::vector<int> diagonal_;
+    std::vector<double> values_;
+    // For each entry of the source matrix, its position in values_.
+    std::vector<int> value_position_;
+};
+
+} // namespace equelle
@@ -10,7 +10,6 @@
 #include <opm/common/utility/parameters/ParameterGroup.hpp>
 #include <opm/grid/UnstructuredGrid.h>
 #include <opm/grid/GridManager.hpp>
-#include <opm/core/linalg/LinearSolverFactory.hpp>
 #include <opm/autodiff/AutoDiffBlock.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
 
@@ -22,8 +21,15 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <cstdint>
 
 #include "equelle/equelleTypes.hpp"
+#include "equelle/AutoDiffKernels.hpp"
+#include "equelle/FieldFile.hpp"
+#include "equelle/LinearSolver.hpp"
+#include "equelle/OutputWriter.hpp"
+#include "equelle/SolverTelemetry.hpp"
 
 namespace equelle {
 
@@ -35,39 +41,55 @@ class StencilCollOfScalar;
 class EquelleRuntimeCPU
 {
 public:
-    /// Constructor.
+    /// Constructor. When built with OpenMP, the "threads" parameter
+    /// (default 1, 0 for one per processor) sets the number of threads
+    /// used by the runtime's loops, the linear solvers and Eigen. This
+    /// includes the jacobians of products and quotients of CollOfScalar,
+    /// see multiply(). Elementwise arithmetic on the values of
+    /// collections is evaluated by Eigen, which does not thread it, and
+    /// stays serial.
     EquelleRuntimeCPU( const Opm::ParameterGroup& param );
     EquelleRuntimeCPU( const UnstructuredGrid* grid, const Opm::ParameterGroup& param );
 
+    /// Destructor.
+    ~EquelleRuntimeCPU();
+
     /** @name Topology
      * Topology and geometry related. */
     ///@{
     CollOfCell allCells() const;
-    CollOfCell boundaryCells() const;
-    CollOfCell interiorCells() const;
+    const CollOfCell& boundaryCells() const;
+    const CollOfCell& interiorCells() const;
     CollOfFace allFaces() const;
-    CollOfFace boundaryFaces() const;
-    CollOfFace interiorFaces() const;
+    const CollOfFace& boundaryFaces() const;
+    const CollOfFace& interiorFaces() const;
     CollOfCell firstCell(const CollOfFace& faces) const;
     CollOfCell secondCell(const CollOfFace& faces) const;
     CollOfScalar norm(const CollOfFace& faces) const;
     CollOfScalar norm(const CollOfCell& cells) const;
     CollOfScalar norm(const CollOfVector& vectors) const;
-    CollOfScalar norm(const CollOfScalar& scalars) const;
+    CollOfScalar norm(const CollOfScalar::ADB& scalars) const;
+    CollOfScalarValue norm(const CollOfScalarValue& scalars) const;
     CollOfVector centroid(const CollOfFace& faces) const;
     CollOfVector centroid(const CollOfCell& cells) const;
     CollOfVector normal(const CollOfFace& faces) const;
     ///@}
 
     /** @name Math
-     * Operators and math functions. */
+     * Operators and math functions. The CollOfScalarValue overloads
+     * compute values only, and skip all derivative bookkeeping. */
     ///@{
-    CollOfScalar sqrt(const CollOfScalar& x) const;
+    CollOfScalar sqrt(const CollOfScalar::ADB& x) const;
+    CollOfScalarValue sqrt(const CollOfScalarValue& x) const;
     CollOfScalar dot(const CollOfVector& v1, const CollOfVector& v2) const;
-    CollOfScalar gradient(const CollOfScalar& cell_scalarfield) const;
-    CollOfScalar negGradient(const CollOfScalar& cell_scalarfield) const;
-    CollOfScalar divergence(const CollOfScalar& face_fluxes) const;
-    CollOfScalar interiorDivergence(const CollOfScalar& face_fluxes) const;
+    CollOfScalar gradient(const CollOfScalar::ADB& cell_scalarfield) const;
+    CollOfScalarValue gradient(const CollOfScalarValue& cell_scalarfield) const;
+    CollOfScalar negGradient(const CollOfScalar::ADB& cell_scalarfield) const;
+    CollOfScalarValue negGradient(const CollOfScalarValue& cell_scalarfield) const;
+    CollOfScalar divergence(const CollOfScalar::ADB& face_fluxes) const;
+    CollOfScalarValue divergence(const CollOfScalarValue& face_fluxes) const;
+    CollOfScalar interiorDivergence(const CollOfScalar::ADB& face_fluxes) const;
+    CollOfScalarValue interiorDivergence(const CollOfScalarValue& face_fluxes) const;
     CollOfBool isEmpty(const CollOfCell& cells) const;
     CollOfBool isEmpty(const CollOfFace& faces) const;
 
@@ -75,8 +97,12 @@ public:
     template <class EntityCollection>
     CollOfScalar operatorExtend(const Scalar data, const EntityCollection& to_set);
 
+    /// As operatorExtend(data, to_set), for values that need no derivatives.
+    template <class EntityCollection>
+    CollOfScalarValue operatorExtendValue(const Scalar data, const EntityCollection& to_set);
+
     template <class SomeCollection, class EntityCollection>
-    SomeCollection operatorExtend(const SomeCollection& data, const EntityCollection& from_set, const EntityCollection& to_set);
+    typename CollType<SomeCollection>::Type operatorExtend(const SomeCollection& data, const EntityCollection& from_set, const EntityCollection& to_set);
 
     template <class SomeCollection, class EntityCollection>
     typename CollType<SomeCollection>::Type operatorOn(const SomeCollection& data, const EntityCollection& from_set, const EntityCollection& to_set);
@@ -91,28 +117,79 @@ public:
 
     /** @name Reductions. */
     ///@{
-    Scalar minReduce(const CollOfScalar& x) const;
-    Scalar maxReduce(const CollOfScalar& x) const;
-    Scalar sumReduce(const CollOfScalar& x) const;
-    Scalar prodReduce(const CollOfScalar& x) const;
+    Scalar minReduce(const CollOfScalar::ADB& x) const;
+    Scalar maxReduce(const CollOfScalar::ADB& x) const;
+    Scalar sumReduce(const CollOfScalar::ADB& x) const;
+    Scalar prodReduce(const CollOfScalar::ADB& x) const;
+    Scalar minReduce(const CollOfScalarValue& x) const;
+    Scalar maxReduce(const CollOfScalarValue& x) const;
+    Scalar sumReduce(const CollOfScalarValue& x) const;
+    Scalar prodReduce(const CollOfScalarValue& x) const;
     ///@}
 
     /// @name Solver functions.
+    /// The Newton iterations stop after "max_iter" (default 10)
+    /// iterations, or when the two-norm of the residual is below
+    /// "abs_res_tol" (default 1e-6), or below "rel_res_tol" (default 0,
+    /// disabled) times its initial norm, or when the max-norm of the
+    /// update is below "update_tol" (default 0, disabled) times
+    /// 1 + the max-norm of the solution.
+    ///
+    /// With newton_forcing=EisenstatWalker the tolerance of iterative
+    /// linear solvers is adapted to the progress of the iterations
+    /// (choice 2 of Eisenstat and Walker), up to "forcing_max" (default
+    /// 0.9). The default, newton_forcing=constant, always uses the
+    /// solver_tol of LinearSolver.
+    ///
+    /// With line_search=true each update is cut in half, at most
+    /// "line_search_max_cuts" (default 8) times, until the residual norm
+    /// decreases by the Armijo condition.
+    ///
+    /// With jfnk=true the Newton iterations are Jacobian-free: the full
+    /// jacobian is never assembled (unless needed for the preconditioner,
+    /// see LinearSolver), and the linear systems are solved with the
+    /// products of the jacobian and a vector, computed as directional
+    /// derivatives of the residual function.
+    ///
+    /// Each call site of newtonSolve() or newtonSolveSystem() has its own
+    /// LinearSolver, kept for the lifetime of the runtime, so that matrix
+    /// storage and preconditioners carry over between timesteps. The
+    /// compiler numbers the sites 1, 2, ... in the order they appear in
+    /// the program and passes the number as the site argument, and the
+    /// linear solver parameters of site k can be given with the prefix
+    /// newton<k>_, e.g. newton2_preconditioner_rebuild_iterations.
+    ///
+    /// Every solve adds a record of its iterations, linear iterations,
+    /// residual norms and timings to solverTelemetry(), also a solve that
+    /// fails with an exception. The records are written at the end of the
+    /// run, and when a solve fails, to "telemetry_filename" if given, as
+    /// CSV if it ends with .csv and as JSON otherwise. With jfnk=true the
+    /// directional derivatives are counted as linear solver time.
     ///@{
     template <class ResidualFunctor>
     CollOfScalar newtonSolve(const ResidualFunctor& rescomp,
-                             const CollOfScalar& u_initialguess);
+                             const CollOfScalar& u_initialguess,
+                             const int site);
 
 
     template <class ... ResFuncs, class ... Colls>
     std::tuple<Colls...> newtonSolveSystem(const std::tuple<ResFuncs...>& rescomp,
-                                           const std::tuple<Colls...>& u_initialguess);
+                                           const std::tuple<Colls...>& u_initialguess,
+                                           const int site);
+
+    const SolverTelemetry& solverTelemetry() const;
     ///@}
 
     /// @name Output
     ///@{
-    void output(const String& tag, Scalar val) const;
-    void output(const String& tag, const CollOfScalar& vals);
+    /// Outputs are written or skipped as selected by OutputWriter::nextStep().
+    void output(const String& tag, Scalar val);
+    void output(const String& tag, const CollOfScalar::ADB& vals);
+    void output(const String& tag, const CollOfScalarValue& vals);
+    /// Writes step of tag, for backends that select outputs with
+    /// outputWriter().nextStep() before gathering the values.
+    void output(const String& tag, int step, const CollOfScalarValue& vals);
+    OutputWriter& outputWriter();
     ///@}
 
     /// @name Input
@@ -123,41 +200,158 @@ public:
                                    const CollOfFace& superset);
     CollOfCell inputDomainSubsetOf(const String& name,
                                    const CollOfCell& superset);
+    /// Reads <name>_filename if <name>_from_file is true. The file is a
+    /// binary FieldFile if <name>_format is binary, or if it is auto (the
+    /// default) and the filename ends in .eqf, and an AsciiFile otherwise.
     template <class SomeCollection>
     CollOfScalar inputCollectionOfScalar(const String& name,
                                          const SomeCollection& coll);
 
+    /// Reads <name>_filename, binary or ASCII as for inputCollectionOfScalar().
     SeqOfScalar inputSequenceOfScalar(const String& name);
     ///@}
 
     /// Ensuring requirements that may be imposed by Equelle programs.
     void ensureGridDimensionMin(const int minimum_grid_dimension) const;
 
+    /// @name Statistics
+    ///@{
+    /// Number of operatorOn()/operatorExtend() calls that found their
+    /// index map in the cache (hits), or had to compute it (misses).
+    int subsetIndexCacheHits() const;
+    int subsetIndexCacheMisses() const;
+    ///@}
+
 private:
     /// Topology helpers
-    bool boundaryCell(const int cell_index) const;
+    void initTopology();
+    const CollOfCell* precomputedFaceCells(const CollOfFace& faces, const int side) const;
 
-    /// Creating primary variables.
-    static CollOfScalar singlePrimaryVariable(const CollOfScalar& initial_values);
+    /// Geometry helper
+    void initGeometry();
 
-    /// Solver helper.
-    CollOfScalar solveForUpdate(const CollOfScalar& residual) const;
+    /// Returns the position in superset of each element of subset,
+    /// computed once for each pair of collections and then cached.
+    template <class EntityCollection>
+    const std::vector<int>& subsetIndexMap(const EntityCollection& superset,
+                                           const EntityCollection& subset);
+
+    /// Creating primary variables for the unknowns u, split into parts
+    /// of the sizes in block_pattern. Without a tangent every part gets
+    /// its own identity jacobian block. With a tangent all parts get a
+    /// single jacobian column, holding their part of the tangent, so
+    /// that the jacobians computed from them are directional derivatives.
+    static std::vector<CollOfScalar> primaryVariables(const CollOfScalar::V& u,
+                                                      const std::vector<int>& block_pattern,
+                                                      const CollOfScalar::V* tangent);
+
+    /// The Newton loop of newtonSolve() and newtonSolveSystem(). The
+    /// assembler is called as assemble(u, tangent, residual, jacobian)
+    /// and must fill in the residual for the unknowns u, and its jacobian
+    /// if the tangent is null, or else its directional derivative along
+    /// the tangent as a single column jacobian. The block size is passed
+    /// on to LinearSolver::solve(), and the site selects the solver.
+    template <class ResidualAssembler>
+    CollOfScalar::V newtonIterate(const ResidualAssembler& assemble,
+                                  const CollOfScalar::V& u_initialguess,
+                                  const int block_size,
+                                  const int site);
+
+    /// Returns true if the Newton iterations have converged, for the
+    /// convergence criteria described for newtonSolve(). The update
+    /// norm is the scaled max-norm of the last update.
+    bool newtonConverged(const double res_norm, const double initial_res_norm,
+                         const double update_norm) const;
+
+    /// Jacobian-free solver helper, computing jacobian-vector products
+    /// as directional derivatives with the assembler of newtonIterate().
+    template <class ResidualAssembler>
+    CollOfScalar::V solveJacobianFree(const ResidualAssembler& assemble,
+                                      const CollOfScalar::V& u,
+                                      const CollOfScalar::V& residual,
+                                      const int block_size);
+
+    /// The linear solver of a Newton call site, created on first use.
+    LinearSolver& linearSolver(const int site);
+
+    /// Solver helper. The jacobian storage is recycled, see LinearSolver::solve().
+    CollOfScalar::V solveForUpdate(SparseColMajor& jacobian, const CollOfScalar::V& residual,
+                                   const int block_size);
+
+    /// Writes the solver telemetry to the file given by the
+    /// "telemetry_filename" parameter, if any. Errors are reported to
+    /// std::cerr, not thrown.
+    void writeTelemetry() const;
 
     /// Norms.
-    Scalar twoNorm(const CollOfScalar& vals) const;
+    Scalar twoNorm(const CollOfScalar::V& vals) const;
 
     /// Data members.
     std::unique_ptr<Opm::GridManager> grid_manager_;
     const UnstructuredGrid& grid_;
     Opm::HelperOps ops_;
-    Opm::LinearSolverFactory linsolver_;
+    // Linear solvers of the Newton call sites, and the one in use.
+    std::map<int, std::unique_ptr<LinearSolver> > linsolvers_;
+    LinearSolver* linsolver_;
+    SolverTelemetry telemetry_;
+    std::string telemetry_filename_;
     bool output_to_file_;
     int verbose_;
+    int threads_;
     const Opm::ParameterGroup& param_;
-    std::map<std::string, int> outputcount_;
+    OutputWriter output_writer_;
     // For newtonSolve().
     int max_iter_;
     double abs_res_tol_;
+    double rel_res_tol_;
+    double update_tol_;
+    bool eisenstat_walker_;
+    double forcing_max_;
+    bool line_search_;
+    int line_search_max_cuts_;
+    bool jacobian_free_;
+    // Topology sets, computed once by initTopology().
+    CollOfCell boundary_cells_;
+    CollOfCell interior_cells_;
+    CollOfFace boundary_faces_;
+    CollOfFace interior_faces_;
+    // First (index 0) and second (index 1) cells of all faces,
+    // interior faces and boundary faces.
+    CollOfCell all_face_cells_[2];
+    CollOfCell interior_face_cells_[2];
+    CollOfCell boundary_face_cells_[2];
+    // Faces of each cell in compressed row storage, with the sign of the
+    // flux out of the cell, and the position of each face among the
+    // interior faces (-1 for boundary faces).
+    std::vector<int> cell_face_start_;
+    std::vector<int> cell_face_;
+    std::vector<double> cell_face_sign_;
+    std::vector<int> interior_face_index_;
+    // Stencils of gradient(), negGradient(), interiorDivergence() and
+    // divergence() on all faces.
+    RowStencil grad_stencil_;
+    RowStencil ngrad_stencil_;
+    RowStencil div_stencil_;
+    RowStencil fulldiv_stencil_;
+    // Geometry in structure-of-arrays layout, one column per
+    // coordinate direction, computed once by initGeometry().
+    CollOfVector::Values cell_centroids_;
+    CollOfVector::Values face_centroids_;
+    CollOfVector::Values face_unit_normals_;
+    CollOfScalar::V face_areas_;
+    CollOfScalar::V cell_volumes_;
+    // Index maps for operatorOn() and operatorExtend(), keyed by the
+    // identities of the (superset, subset) pair.
+    struct SubsetIndexMap
+    {
+        std::weak_ptr<const void> superset;
+        std::weak_ptr<const void> subset;
+        std::vector<int> indices;
+    };
+    std::map<std::pair<std::uint64_t, std::uint64_t>, SubsetIndexMap> subset_index_cache_;
+    std::size_t subset_index_cache_prune_size_;
+    int subset_index_cache_hits_;
+    int subset_index_cache_misses_;
 };
 
 
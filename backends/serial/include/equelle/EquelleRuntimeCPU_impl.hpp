@@ -7,8 +7,13 @@
 #include <fstream>
 #include <iterator>
 #include <array>
+#include <tuple>
+#include <utility>
+#include <limits>
+#include <algorithm>
 #include <opm/grid/utility/StopWatch.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include "equelle/AutoDiffKernels.hpp"
 
 namespace equelle {
 
@@ -20,6 +25,14 @@ CollOfScalar EquelleRuntimeCPU::operatorExtend(const double data,
 }
 
 
+template <class EntityCollection>
+CollOfScalarValue EquelleRuntimeCPU::operatorExtendValue(const double data,
+                                                         const EntityCollection& to_set)
+{
+    return CollOfScalarValue(CollOfScalar::V::Constant(to_set.size(), data));
+}
+
+
 namespace
 {
     using Opm::subset;
@@ -33,11 +46,22 @@ namespace
             return std::vector<int>();
         }
 
+        const std::size_t sub_sz = subset.size();
+        if (superset.isFull()) {
+            // The position of an entity in a full set is its index,
+            // so no searching is necessary.
+            std::vector<int> indices(sub_sz);
+            for (std::size_t elem = 0; elem < sub_sz; ++elem) {
+                indices[elem] = subset[elem].index;
+                assert(indices[elem] >= 0 && indices[elem] < int(superset.size()));
+            }
+            return indices;
+        }
+
         assert(std::is_sorted(superset.begin(), superset.end()));
         assert(std::adjacent_find(superset.begin(), superset.end()) == superset.end());
         assert(superset[0].index >= 0);
 
-        const std::size_t sub_sz = subset.size();
         typedef typename EntityCollection::value_type Entity;
         std::vector<std::pair<Entity, int> > sub_indexed(sub_sz);
         for (std::size_t elem = 0; elem < sub_sz; ++elem) {
@@ -82,42 +106,160 @@ namespace
         return indices;
     }
 
-    template <class EntityType, class IntVec>
-    std::vector<EntityType> subset(const std::vector<EntityType>& x,
-                                   const IntVec& indices)
+    /// Presents the entity indices of a collection as an index
+    /// vector, for use with subset() and superset() when the other
+    /// collection is a full set and positions equal entity indices.
+    template <class EntityCollection>
+    class EntityIndices
+    {
+    public:
+        explicit EntityIndices(const EntityCollection& entities)
+            : entities_(entities)
+        {
+        }
+        int operator[](const int i) const
+        {
+            return entities_[i].index;
+        }
+        int size() const
+        {
+            return entities_.size();
+        }
+    private:
+        const EntityCollection& entities_;
+    };
+
+    template <int Codim, class IntVec>
+    TopologicalCollection<Codim> subset(const TopologicalCollection<Codim>& x,
+                                        const IntVec& indices)
     {
         const size_t sz = indices.size();
-        std::vector<EntityType> retval;
+        std::vector<TopologicalEntity<Codim>> retval;
         retval.reserve(sz);
         for (size_t i = 0; i < sz; ++i) {
             retval.push_back(x[indices[i]]);
         }
-        return retval;
+        return TopologicalCollection<Codim>(std::move(retval));
     }
 
-    template <class EntityType, class IntVec>
-    std::vector<EntityType> superset(const std::vector<EntityType>& x,
-                                     const IntVec& indices,
-                                     const int n)
+    template <int Codim, class IntVec>
+    TopologicalCollection<Codim> superset(const TopologicalCollection<Codim>& x,
+                                          const IntVec& indices,
+                                          const int n)
     {
         assert(x.size() == indices.size());
         const size_t sz = indices.size();
-        std::vector<EntityType> retval(n);
+        std::vector<TopologicalEntity<Codim>> retval(n);
         for (size_t i = 0; i < sz; ++i) {
             retval[indices[i]] = x[i];
         }
+        return TopologicalCollection<Codim>(std::move(retval));
+    }
+
+    // These are more specialized than the Opm::subset() and
+    // Opm::superset() templates for AutoDiffBlock, and move rows of
+    // the jacobians directly instead of multiplying every block by a
+    // selection matrix.
+    template <class IntVec>
+    CollOfScalar subset(const CollOfScalar::ADB& x,
+                        const IntVec& indices)
+    {
+        return gather(x, indices);
+    }
+
+    template <class IntVec>
+    CollOfScalar superset(const CollOfScalar::ADB& x,
+                          const IntVec& indices,
+                          const int n)
+    {
+        return scatter(x, indices, n);
+    }
+
+    template <class IntVec>
+    CollOfScalarValue subset(const CollOfScalarValue& x,
+                             const IntVec& indices)
+    {
+        const int n = indices.size();
+        CollOfScalarValue retval(n);
+        for (int i = 0; i < n; ++i) {
+            retval[i] = x[indices[i]];
+        }
+        return retval;
+    }
+
+    template <class IntVec>
+    CollOfScalarValue superset(const CollOfScalarValue& x,
+                               const IntVec& indices,
+                               const int n)
+    {
+        const int sz = indices.size();
+        CollOfScalarValue retval = CollOfScalarValue::Zero(n);
+        for (int i = 0; i < sz; ++i) {
+            retval[indices[i]] = x[i];
+        }
         return retval;
     }
 } // anon namespace
 
+
+template <class EntityCollection>
+const std::vector<int>& EquelleRuntimeCPU::subsetIndexMap(const EntityCollection& superset,
+                                                          const EntityCollection& subset)
+{
+    if (subset.empty()) {
+        static const std::vector<int> no_indices;
+        return no_indices;
+    }
+
+    // Since collections share their identity with their copies, the
+    // same pair of sets used repeatedly (typically in a time loop) will
+    // find its index map here after the first time.
+    const auto key = std::make_pair(superset.id(), subset.id());
+    auto it = subset_index_cache_.find(key);
+    if (it != subset_index_cache_.end()) {
+        ++subset_index_cache_hits_;
+        return it->second.indices;
+    }
+    ++subset_index_cache_misses_;
+
+    // Before growing the cache, remove maps for collections that no longer exist.
+    if (subset_index_cache_.size() >= subset_index_cache_prune_size_) {
+        for (auto entry = subset_index_cache_.begin(); entry != subset_index_cache_.end(); ) {
+            const bool superset_gone = entry->first.first != 0 && entry->second.superset.expired();
+            if (superset_gone || entry->second.subset.expired()) {
+                entry = subset_index_cache_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+        subset_index_cache_prune_size_ = std::max(std::size_t(64), 2*subset_index_cache_.size());
+    }
+
+    SubsetIndexMap& map = subset_index_cache_[key];
+    map.superset = superset.storage();
+    map.subset = subset.storage();
+    map.indices = subsetIndices(superset, subset);
+    return map.indices;
+}
+
 template <class SomeCollection, class EntityCollection>
-SomeCollection EquelleRuntimeCPU::operatorExtend(const SomeCollection& data,
+typename CollType<SomeCollection>::Type
+EquelleRuntimeCPU::operatorExtend(const SomeCollection& data,
                                                  const EntityCollection& from_set,
                                                  const EntityCollection& to_set)
 {
     assert(size_t(data.size()) == size_t(from_set.size()));
+    if (from_set.isFull() && to_set.isFull()) {
+        // Extending from the full set to itself.
+        assert(from_set.size() == to_set.size());
+        return data;
+    }
+    if (to_set.isFull()) {
+        // Scatter directly to the entity indices of from_set.
+        return superset(data, EntityIndices<EntityCollection>(from_set), to_set.size());
+    }
     // Expand with zeros.
-    std::vector<int> indices = subsetIndices(to_set, from_set);
+    const std::vector<int>& indices = subsetIndexMap(to_set, from_set);
     assert(indices.size() == from_set.size());
     return superset(data, indices, to_set.size());
 }
@@ -134,137 +276,407 @@ EquelleRuntimeCPU::operatorOn(const SomeCollection& data,
     // in the sense that all (possibly repeated) elements of to_set
     // are found in from_set.
     assert(size_t(data.size()) == size_t(from_set.size()));
+    if (from_set.isFull() && to_set.isFull()) {
+        // Restricting the full set to itself.
+        assert(from_set.size() == to_set.size());
+        return data;
+    }
+    if (from_set.isFull()) {
+        // Gather directly from the entity indices of to_set. This is
+        // the common case of restricting a field on AllCells() to
+        // FirstCell() or SecondCell() of some faces.
+        return subset(data, EntityIndices<EntityCollection>(to_set));
+    }
     // Extract subset.
-    std::vector<int> indices = subsetIndices(from_set, to_set);
+    const std::vector<int>& indices = subsetIndexMap(from_set, to_set);
     assert(indices.size() == to_set.size());
     return subset(data, indices);
 }
 
 
 
+namespace
+{
+    /// Select from two CollOfScalar objects, with derivatives.
+    inline CollOfScalar selectWithDerivatives(const CollOfBool& predicate,
+                                              const CollOfScalar& iftrue,
+                                              const CollOfScalar& iffalse)
+    {
+        return equelle::select(predicate, iftrue, iffalse);
+    }
+
+    /// Select elementwise from two collections of scalar values, as a
+    /// single blend that the compiler can vectorise.
+    template <class SomeCollection1, class SomeCollection2>
+    CollOfScalarValue selectValues(const CollOfBool& predicate,
+                                   const SomeCollection1& iftrue,
+                                   const SomeCollection2& iffalse,
+                                   std::true_type /* scalar values */)
+    {
+        assert(predicate.size() == iftrue.size() && predicate.size() == iffalse.size());
+        return CollOfScalarValue(predicate.select(iftrue, iffalse));
+    }
+
+    /// Sets element i of a collection.
+    template <class Collection, class Value>
+    void setElement(Collection& coll, const size_t i, const Value& value)
+    {
+        coll[i] = value;
+    }
+
+    /// Sets element i of a topological collection, which has no
+    /// mutable element access.
+    template <int Codim>
+    void setElement(TopologicalCollection<Codim>& coll, const size_t i, const TopologicalEntity<Codim>& entity)
+    {
+        coll.set(i, entity);
+    }
+
+    /// Select elementwise from two collections of any other type.
+    template <class SomeCollection1, class SomeCollection2>
+    typename CollType<SomeCollection1>::Type selectValues(const CollOfBool& predicate,
+                                                          const SomeCollection1& iftrue,
+                                                          const SomeCollection2& iffalse,
+                                                          std::false_type /* scalar values */)
+    {
+        const size_t sz = predicate.size();
+        assert(sz == size_t(iftrue.size()) && sz == size_t(iffalse.size()));
+        typename CollType<SomeCollection1>::Type retval = iftrue;
+        for (size_t i = 0; i < sz; ++i) {
+            if (!predicate[i]) {
+                setElement(retval, i, iffalse[i]);
+            }
+        }
+        return retval;
+    }
+
+    /// Select elementwise from two collections without derivatives.
+    template <class SomeCollection1, class SomeCollection2>
+    typename CollType<SomeCollection1>::Type select(const CollOfBool& predicate,
+                                                    const SomeCollection1& iftrue,
+                                                    const SomeCollection2& iffalse,
+                                                    std::false_type /* has derivatives */)
+    {
+        typedef std::is_same<typename CollType<SomeCollection1>::Type, CollOfScalarValue> ScalarValues;
+        return selectValues(predicate, iftrue, iffalse, ScalarValues());
+    }
+
+    /// Select when at least one side is a CollOfScalar. The result
+    /// type follows the true side, as for the other cases.
+    template <class SomeCollection1, class SomeCollection2>
+    typename CollType<SomeCollection1>::Type select(const CollOfBool& predicate,
+                                                    const SomeCollection1& iftrue,
+                                                    const SomeCollection2& iffalse,
+                                                    std::true_type /* has derivatives */)
+    {
+        return selectWithDerivatives(predicate, iftrue, iffalse);
+    }
+} // anon namespace
+
+
 template <class SomeCollection1, class SomeCollection2>
 typename CollType<SomeCollection1>::Type
 EquelleRuntimeCPU::trinaryIf(const CollOfBool& predicate,
                              const SomeCollection1& iftrue,
                              const SomeCollection2& iffalse) const
 {
-    const size_t sz = predicate.size();
-    assert(sz == size_t(iftrue.size()) && sz == size_t(iffalse.size()));
-    SomeCollection1 retval = iftrue;
-    for (size_t i = 0; i < sz; ++i) {
-        if (!predicate[i]) {
-            retval[i] = iffalse[i];
-        }
-    }
-    return retval;
+    typedef std::integral_constant<bool,
+                                   std::is_base_of<CollOfScalar::ADB, SomeCollection1>::value
+                                   || std::is_base_of<CollOfScalar::ADB, SomeCollection2>::value> HasDerivatives;
+    return select(predicate, iftrue, iffalse, HasDerivatives());
 }
 
 
-template <>
-inline CollOfScalar EquelleRuntimeCPU::trinaryIf<CollOfScalar, CollOfScalar>(const CollOfBool& predicate,
-                                                                             const CollOfScalar& iftrue,
-                                                                             const CollOfScalar& iffalse) const
+namespace
 {
-    const int sz = predicate.size();
-    assert(sz == iftrue.size() && sz == iffalse.size());
-    CollOfScalar::V trueones = CollOfScalar::V::Constant(sz, 1.0);
-    CollOfScalar::V falseones = CollOfScalar::V::Constant(sz, 0.0);
-    for (int i = 0; i < sz; ++i) {
-        if (!predicate[i]) {
-            trueones[i] = 0.0;
-            falseones[i] = 1.0;
+    /// Restores the tolerance a linear solver has on construction when
+    /// going out of scope, also if a solve throws.
+    class ToleranceGuard
+    {
+    public:
+        explicit ToleranceGuard(LinearSolver& solver)
+            : solver_(solver), tol_(solver.tolerance())
+        {
+        }
+        ~ToleranceGuard()
+        {
+            solver_.setTolerance(tol_);
         }
+        ToleranceGuard(const ToleranceGuard&) = delete;
+        ToleranceGuard& operator=(const ToleranceGuard&) = delete;
+    private:
+        LinearSolver& solver_;
+        const double tol_;
+    };
+
+    /// Calls the residual function f with the unknowns as arguments.
+    template <class ResidualFunction, std::size_t ... J>
+    CollOfScalar callWithUnknowns(const ResidualFunction& f,
+                                  const std::vector<CollOfScalar>& unknowns,
+                                  std::index_sequence<J...>)
+    {
+        return f(unknowns[J]...);
     }
-    CollOfScalar retval = iftrue * trueones + iffalse * falseones;
-    return retval;
-}
 
-template <>
-inline CollOfScalar
-EquelleRuntimeCPU::trinaryIf<CollOfScalar::ADB, CollOfScalar>(const CollOfBool& predicate,
-                                                              const CollOfScalar::ADB& iftrue,
-                                                              const CollOfScalar& iffalse) const
-{
-    return trinaryIf<CollOfScalar, CollOfScalar>(predicate, iftrue, iffalse);
-}
+    /// Evaluates all residual functions of a system for the unknowns.
+    template <class ResFuncs, std::size_t ... I>
+    void evaluateSystem(const ResFuncs& rescomp,
+                        const std::vector<CollOfScalar>& unknowns,
+                        std::vector<CollOfScalar>& residuals,
+                        std::index_sequence<I...> indices)
+    {
+        // Expanding into an array initializer evaluates in order.
+        const int dummy[] = { (residuals[I] = callWithUnknowns(std::get<I>(rescomp), unknowns, indices), 0)... };
+        static_cast<void>(dummy);
+    }
+
+    /// The values of the initial guesses of a system.
+    template <class Colls, std::size_t ... I>
+    std::vector<CollOfScalar::V> systemValues(const Colls& u, std::index_sequence<I...>)
+    {
+        return std::vector<CollOfScalar::V>{ CollOfScalarValue(std::get<I>(u))... };
+    }
+
+    /// Splits the solution of a system into the parts of each unknown.
+    template <class Colls, std::size_t ... I>
+    Colls splitSystem(const CollOfScalar::V& u,
+                      const std::vector<int>& start,
+                      std::index_sequence<I...>)
+    {
+        return Colls(typename std::tuple_element<I, Colls>::type(
+                         CollOfScalarValue(u.segment(start[I], start[I + 1] - start[I])))...);
+    }
+} // anonymous namespace
+
 
-template <>
-inline CollOfScalar
-EquelleRuntimeCPU::trinaryIf<CollOfScalar, CollOfScalar::ADB>(const CollOfBool& predicate,
-                                                              const CollOfScalar& iftrue,
-                                                              const CollOfScalar::ADB& iffalse) const
+template <class ResidualFunctor>
+CollOfScalar EquelleRuntimeCPU::newtonSolve(const ResidualFunctor& rescomp,
+                                            const CollOfScalar& u_initialguess,
+                                            const int site)
 {
-    return trinaryIf<CollOfScalar, CollOfScalar>(predicate, iftrue, iffalse);
+    const std::vector<int> block_pattern(1, u_initialguess.size());
+    const std::vector<int> tangent_pattern(1, 1);
+    std::vector<CollOfScalar> residuals(1);
+    auto assemble = [&](const CollOfScalar::V& u, const CollOfScalar::V* tangent,
+                        CollOfScalar::V& residual, SparseColMajor& jacobian) {
+        residuals[0] = rescomp(primaryVariables(u, block_pattern, tangent)[0]);
+        assembleSystem(residuals, tangent ? tangent_pattern : block_pattern, residual, jacobian);
+    };
+    return newtonIterate(assemble, u_initialguess.value(), 1, site);
 }
 
-template <>
-inline CollOfScalar
-EquelleRuntimeCPU::trinaryIf<CollOfScalar::ADB, CollOfScalar::ADB>(const CollOfBool& predicate,
-                                                                   const CollOfScalar::ADB& iftrue,
-                                                                   const CollOfScalar::ADB& iffalse) const
+
+template <class ... ResFuncs, class ... Colls>
+std::tuple<Colls...> EquelleRuntimeCPU::newtonSolveSystem(const std::tuple<ResFuncs...>& rescomp,
+                                                          const std::tuple<Colls...>& u_initialguess,
+                                                          const int site)
 {
-    return trinaryIf<CollOfScalar, CollOfScalar>(predicate, iftrue, iffalse);
+    static_assert(sizeof...(ResFuncs) == sizeof...(Colls), "Size of residual function and initial guess arrays must be identical.");
+    typedef std::make_index_sequence<sizeof...(Colls)> Indices;
+    const int num = sizeof...(Colls);
+
+    // Unknown i occupies the elements of the combined unknown (and the
+    // columns of the jacobian) following those of unknowns 0..i-1.
+    const std::vector<CollOfScalar::V> parts = systemValues(u_initialguess, Indices());
+    std::vector<int> block_pattern(num);
+    std::vector<int> start(num + 1, 0);
+    for (int i = 0; i < num; ++i) {
+        block_pattern[i] = parts[i].size();
+        start[i + 1] = start[i] + block_pattern[i];
+    }
+    CollOfScalar::V u_initial(start[num]);
+    for (int i = 0; i < num; ++i) {
+        u_initial.segment(start[i], block_pattern[i]) = parts[i];
+    }
+
+    // Each residual function gets all unknowns, as primary variables
+    // with one jacobian block each, and the residuals are assembled
+    // directly into the global residual and jacobian.
+    const std::vector<int> tangent_pattern(1, 1);
+    std::vector<CollOfScalar> residuals(num);
+    auto assemble = [&](const CollOfScalar::V& u, const CollOfScalar::V* tangent,
+                        CollOfScalar::V& residual, SparseColMajor& jacobian) {
+        const std::vector<CollOfScalar> unknowns = primaryVariables(u, block_pattern, tangent);
+        evaluateSystem(rescomp, unknowns, residuals, Indices());
+        assembleSystem(residuals, tangent ? tangent_pattern : block_pattern, residual, jacobian);
+    };
+    // Unknowns of equal size (such as all on AllCells()) are solved for
+    // with one block of equations and unknowns per element.
+    const bool equal_sizes = std::count(block_pattern.begin(), block_pattern.end(), block_pattern[0]) == num;
+    const CollOfScalar::V u = newtonIterate(assemble, u_initial, equal_sizes ? num : 1, site);
+
+    return splitSystem<std::tuple<Colls...>>(u, start, Indices());
 }
 
 
-template <class ResidualFunctor>
-CollOfScalar EquelleRuntimeCPU::newtonSolve(const ResidualFunctor& rescomp,
-                                            const CollOfScalar& u_initialguess)
+template <class ResidualAssembler>
+CollOfScalar::V EquelleRuntimeCPU::newtonIterate(const ResidualAssembler& assemble,
+                                                 const CollOfScalar::V& u_initialguess,
+                                                 const int block_size,
+                                                 const int site)
 {
     Opm::time::StopWatch clock;
     clock.start();
 
+    linsolver_ = &linearSolver(site);
+
+    // Telemetry of this solve, and of the current iteration.
+    const NewtonIterationRecord no_iteration = { 0.0, 0, 0.0, 0.0, 0.0 };
+    NewtonSolveRecord record;
+    record.site = site;
+    NewtonIterationRecord current = no_iteration;
+
     // Set up Newton loop.
-    CollOfScalar u = singlePrimaryVariable(u_initialguess);
+    CollOfScalar::V u = u_initialguess;
+    CollOfScalar::V residual;
+    SparseColMajor jacobian;
+    // Jacobian-free iterations evaluate the residual with a zero
+    // tangent, which costs little more than evaluating values only.
+    const CollOfScalar::V zero_tangent = CollOfScalar::V::Zero(jacobian_free_ ? u.size() : 0);
+    auto evaluate = [&]() {
+        Opm::time::StopWatch assembly_clock;
+        assembly_clock.start();
+        assemble(u, jacobian_free_ ? &zero_tangent : nullptr, residual, jacobian);
+        current.assembly_time += assembly_clock.secsSinceStart();
+    };
     if (verbose_ > 2) {
-        output("Initial u", u);
+        output("Initial u", CollOfScalarValue(u));
         output("    newtonSolve: norm (initial u)", twoNorm(u));
     }
-    CollOfScalar residual = rescomp(u);
+    evaluate();
     if (verbose_ > 2) {
-        output("Initial residual", residual);
+        output("Initial residual", CollOfScalarValue(residual));
         output("    newtonSolve: norm (initial residual)", twoNorm(residual));
     }
 
     int iter = 0;
+    double res_norm = twoNorm(residual);
+    const double initial_res_norm = res_norm;
+    current.residual_norm = res_norm;
+    record.iterations.push_back(current);
+    double update_norm = std::numeric_limits<double>::max();
+
+    // Linear solver tolerance, adapted with Eisenstat-Walker forcing,
+    // and restored on return.
+    const ToleranceGuard base_linear_tol(*linsolver_);
+    double forcing = std::min(0.5, forcing_max_);
 
     // Debugging output not specified in Equelle.
     if (verbose_ > 1) {
         std::cout << "    newtonSolve: iter = " << iter << " (max = " << max_iter_
-                  << "), norm(residual) = " << twoNorm(residual)
+                  << "), norm(residual) = " << res_norm
                   << " (tol = " << abs_res_tol_ << ")" << std::endl;
     }
 
-    // Execute newton loop until residual is small or we have used too many iterations.
-    while ( (twoNorm(residual) > abs_res_tol_) && (iter < max_iter_) ) {
+    // Measurements of the linear solve of the current iteration, also
+    // taken when it fails.
+    Opm::time::StopWatch solve_clock;
+    bool solving = false;
+    auto recordSolve = [&]() {
+        current.solve_time = solve_clock.secsSinceStart();
+        current.linear_iterations = linsolver_->lastIterations();
+        current.setup_time = linsolver_->lastSetupTime();
+        solving = false;
+    };
 
-        // Solve linear equations for du, apply update.
-        const CollOfScalar du = solveForUpdate(residual);
-        u = u - du;
+    // Execute newton loop until converged or we have used too many iterations.
+    try {
+        while ( !newtonConverged(res_norm, initial_res_norm, update_norm) && (iter < max_iter_) ) {
 
-        // Recompute residual.
-        residual = rescomp(u);
+            // Solve linear equations for du, apply update.
+            if (eisenstat_walker_) {
+                linsolver_->setTolerance(forcing);
+            }
+            current = no_iteration;
+            solving = true;
+            solve_clock.start();
+            const CollOfScalar::V du = jacobian_free_
+                ? solveJacobianFree(assemble, u, residual, block_size)
+                : solveForUpdate(jacobian, residual, block_size);
+            recordSolve();
+            u -= du;
+
+            // Recompute residual.
+            evaluate();
+            double new_res_norm = twoNorm(residual);
+
+            // Backtrack until the Armijo condition holds.
+            double step = 1.0;
+            if (line_search_) {
+                const double armijo = 1e-4;
+                for (int cut = 0; cut < line_search_max_cuts_; ++cut) {
+                    if (new_res_norm <= (1.0 - armijo * step) * res_norm) {
+                        break;
+                    }
+                    step *= 0.5;
+                    u += step * du;
+                    evaluate();
+                    new_res_norm = twoNorm(residual);
+                    if (verbose_ > 1) {
+                        std::cout << "    newtonSolve: line search step = " << step
+                                  << ", norm(residual) = " << new_res_norm << std::endl;
+                    }
+                }
+            }
+            update_norm = step * du.abs().maxCoeff() / (1.0 + u.abs().maxCoeff());
+
+            // Eisenstat-Walker choice 2, with safeguards against the
+            // forcing term decreasing too fast and oversolving at the end.
+            if (eisenstat_walker_) {
+                const double gamma = 0.9;
+                const double ratio = new_res_norm / res_norm;
+                double next = gamma * ratio * ratio;
+                const double previous = gamma * forcing * forcing;
+                if (previous > 0.1) {
+                    next = std::max(next, previous);
+                }
+                if (new_res_norm > 0.0) {
+                    next = std::max(next, 0.5 * abs_res_tol_ / new_res_norm);
+                }
+                forcing = std::min(next, forcing_max_);
+            }
+            res_norm = new_res_norm;
+            current.residual_norm = res_norm;
+            record.iterations.push_back(current);
+
+            if (verbose_ > 2) {
+                // Debugging output not specified in Equelle.
+                output("u", CollOfScalarValue(u));
+                output("    newtonSolve: norm(u)", twoNorm(u));
+                output("residual", CollOfScalarValue(residual));
+                output("    newtonSolve: norm(residual)", res_norm);
+            }
 
-        if (verbose_ > 2) {
-            // Debugging output not specified in Equelle.
-            output("u", u);
-            output("    newtonSolve: norm(u)", twoNorm(u));
-            output("residual", residual);
-            output("    newtonSolve: norm(residual)", twoNorm(residual));
-        }
+            ++iter;
 
-        ++iter;
+            // Debugging output not specified in Equelle.
+            if (verbose_ > 1) {
+                std::cout << "    newtonSolve: iter = " << iter << " (max = " << max_iter_
+                          << "), norm(residual) = " << res_norm
+                          << " (tol = " << abs_res_tol_ << ")" << std::endl;
+            }
 
-        // Debugging output not specified in Equelle.
-        if (verbose_ > 1) {
-            std::cout << "    newtonSolve: iter = " << iter << " (max = " << max_iter_
-                      << "), norm(residual) = " << twoNorm(residual)
-                      << " (tol = " << abs_res_tol_ << ")" << std::endl;
         }
-
+    } catch (...) {
+        // Record the failed solve with its unfinished iteration, and
+        // write the telemetry now, as the program may end without
+        // destroying the runtime.
+        if (solving) {
+            recordSolve();
+        }
+        current.residual_norm = std::numeric_limits<double>::quiet_NaN();
+        record.iterations.push_back(current);
+        record.converged = false;
+        record.time = clock.secsSinceStart();
+        telemetry_.add(record);
+        writeTelemetry();
+        throw;
     }
+    record.converged = newtonConverged(res_norm, initial_res_norm, update_norm);
+    record.time = clock.secsSinceStart();
+    telemetry_.add(record);
     if (verbose_ > 0) {
-        if (twoNorm(residual) > abs_res_tol_) {
+        if (!newtonConverged(res_norm, initial_res_norm, update_norm)) {
             std::cout << "Newton solver failed to converge in " << max_iter_ << " iterations" << std::endl;
         } else {
             std::cout << "Newton solver converged in " << iter << " iterations" << std::endl;
@@ -275,67 +687,40 @@ CollOfScalar EquelleRuntimeCPU::newtonSolve(const ResidualFunctor& rescomp,
         std::cout << "Newton solver took: " << clock.secsSinceLast() << " seconds." << std::endl;
     }
 
-    return u.value();
+    return u;
 }
 
 
-template <class ... ResFuncs, class ... Colls>
-std::tuple<Colls...> EquelleRuntimeCPU::newtonSolveSystem(const std::tuple<ResFuncs...>& rescomp_arg,
-                                                          const std::tuple<Colls...>& u_initialguess_arg)
+template <class ResidualAssembler>
+CollOfScalar::V EquelleRuntimeCPU::solveJacobianFree(const ResidualAssembler& assemble,
+                                                     const CollOfScalar::V& u,
+                                                     const CollOfScalar::V& residual,
+                                                     const int block_size)
 {
-    static_assert(sizeof...(ResFuncs) == sizeof...(Colls), "Size of residual function and initial guess arrays must be identical.");
-    enum { Num = sizeof ... (ResFuncs) };
-
-    typedef std::function<CollOfScalar(const CollOfScalar&, const CollOfScalar&)> SingleResFunc;
-    std::array<SingleResFunc, 2> rescomp{{std::get<0>(rescomp_arg), std::get<1>(rescomp_arg)}};
-    std::array<CollOfScalar, 2> u_initialguess{{std::get<0>(u_initialguess_arg), std::get<1>(u_initialguess_arg)}};
-
-    // Set up ranges object.
-    std::array<ESpan, Num> ranges{{ ESpan(0), ESpan(0) }}; // Dummy spans that will be overwritten.
-    int start = 0;
-    for (int i = 0; i < Num; ++i) {
-        const int end = start + u_initialguess[i].size();
-        ranges[i] = ESpan(end - start, 1, start);
-        start = end;
-    }
-    const int total_size = start;
-    std::array<CollOfScalar, Num> temp;
-    std::array<CollOfScalar, Num> tempres;
-
-    // Build combined functor.
-    auto combined_rescomp = [&](const CollOfScalar& u) -> CollOfScalar {
-        // Split into components.
-        for (int i = 0; i < Num; ++i) {
-            temp[i] = subset(u, ranges[i]);
-        }
-        // Call each part.
-        for (int i = 0; i < Num; ++i) {
-            static_assert(Num == 2, "Only systems of 2 equations can be solved."); // Todo: figure out how to do Num arguments in op() below.
-            tempres[i] = rescomp[i](temp[0], temp[1]);
-        }
-        // Recombine
-        CollOfScalar result = superset(tempres[0], ranges[0], total_size);
-        for (int i = 1; i < Num; ++i) {
-            result += superset(tempres[i], ranges[i], total_size);
+    Opm::time::StopWatch clock;
+    clock.start();
+
+    // The jacobian is only assembled for the preconditioner.
+    CollOfScalar::V scratch;
+    auto assemble_jacobian = [&](SparseColMajor& jacobian) {
+        assemble(u, nullptr, scratch, jacobian);
+    };
+    SparseColMajor directional;
+    auto apply = [&](const CollOfScalar::V& v, CollOfScalar::V& jv) {
+        assemble(u, &v, scratch, directional);
+        jv = CollOfScalar::V::Zero(v.size());
+        for (SparseColMajor::InnerIterator it(directional, 0); it; ++it) {
+            jv[it.row()] = it.value();
         }
-        return result;
     };
+    CollOfScalar::V du;
+    linsolver_->solveJacobianFree(apply, assemble_jacobian, residual, du, block_size);
 
-    // Build combined initial guess.
-    CollOfScalar combined_u_initialguess = superset(u_initialguess[0], ranges[0], total_size);
-    for (int i = 1; i < Num; ++i) {
-        combined_u_initialguess += superset(u_initialguess[i], ranges[i], total_size);
-    }
-    std::cout << "Done with setup of combined things." << std::endl;
-
-    // Call regular Newton solver with combined objects.
-    CollOfScalar combined_u = newtonSolve(combined_rescomp, combined_u_initialguess);
-
-    // Extract subparts and return.
-    for (int i = 0; i < Num; ++i) {
-        temp[i] = subset(combined_u, ranges[i]);
+    if (verbose_ > 2) {
+        std::cout << "        solveJacobianFree: Linear solver took: " << clock.secsSinceLast() << " seconds, "
+                  << linsolver_->lastIterations() << " iterations." << std::endl;
     }
-    return std::tuple<Colls...>(temp[0], temp[1]);
+    return du;
 }
 
 
@@ -347,17 +732,29 @@ CollOfScalar EquelleRuntimeCPU::inputCollectionOfScalar(const String& name,
     const bool from_file = param_.getDefault(name + "_from_file", false);
     if (from_file) {
         const String filename = param_.get<String>(name + "_filename");
-        std::ifstream is(filename.c_str());
-        if (!is) {
-            OPM_THROW(std::runtime_error, "Could not find file " << filename);
+        if (isBinaryInput(param_.getDefault<String>(name + "_format", "auto"), filename)) {
+            const FieldEntity entity = std::is_same<SomeCollection, CollOfCell>::value
+                ? FieldEntity::Cells : FieldEntity::Faces;
+            const FieldFile file(filename);
+            if (file.size() != size) {
+                OPM_THROW(std::runtime_error, "Unexpected size of input data for " << name << " in file " << filename);
+            }
+            if (file.entity() != FieldEntity::None && file.entity() != entity) {
+                OPM_THROW(std::runtime_error, "Input data for " << name << " in file " << filename
+                          << " is for " << (entity == FieldEntity::Cells ? "faces" : "cells") << ".");
+            }
+            // The only copy is from the mapped pages into the result.
+            CollOfScalar::V data(size);
+            file.copyTo(data.data());
+            return CollOfScalar(std::move(data));
         }
-        std::istream_iterator<double> beg(is);
-        std::istream_iterator<double> end;
-        std::vector<double> data(beg, end);
-        if (int(data.size()) != size) {
+        const AsciiFile file(filename);
+        if (file.size() != size) {
             OPM_THROW(std::runtime_error, "Unexpected size of input data for " << name << " in file " << filename);
         }
-        return CollOfScalar(CollOfScalar::V(Eigen::Map<CollOfScalar::V>(&data[0], size)));
+        CollOfScalar::V data(size);
+        file.parseTo(data.data());
+        return CollOfScalar(std::move(data));
     } else {
         // Uniform values.
         return CollOfScalar(CollOfScalar::V::Constant(size, param_.get<double>(name)));
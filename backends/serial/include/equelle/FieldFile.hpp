@@ -0,0 +1,123 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace equelle {
+
+/// Entities a field file holds one value for.
+enum class FieldEntity : std::uint32_t { None = 0, Cells = 1, Faces = 2 };
+
+/// Value types of field files.
+enum class FieldType : std::uint32_t { Float64 = 0, Float32 = 1 };
+
+
+/// Read-only, memory-mapped binary field file.
+///
+/// The format is a 32 byte header followed by the values, in the byte
+/// order of the machine that wrote them:
+///
+///     offset  size  content
+///          0     8  magic "EQLFIELD"
+///          8     4  uint32 version, currently 1
+///         12     4  uint32 value type, see FieldType
+///         16     4  uint32 entity kind, see FieldEntity
+///         20     4  uint32 reserved, 0
+///         24     8  uint64 number of values
+///         32        values
+///
+/// Files are normally written with write() and named *.eqf, but any
+/// program can produce them; numpy's tofile() after a hand-made header
+/// will do.
+class FieldFile
+{
+public:
+    /// Maps the file and checks its header, throwing if it is not a
+    /// valid field file.
+    explicit FieldFile(const std::string& filename);
+    ~FieldFile();
+
+    FieldFile(const FieldFile&) = delete;
+    FieldFile& operator=(const FieldFile&) = delete;
+
+    int size() const;
+    FieldType type() const;
+    FieldEntity entity() const;
+
+    /// The values, mapped directly from the file. Only for Float64 files.
+    const double* data() const;
+
+    /// Copies (or converts, for Float32 files) value i.
+    double value(const int i) const;
+
+    /// Copies (or converts) all values to out, which must have room for
+    /// size() values.
+    void copyTo(double* out) const;
+
+    /// Writes n values as a Float64 field file.
+    static void write(const std::string& filename, const double* values,
+                      const int n, const FieldEntity entity);
+
+private:
+    std::string filename_;
+    char* map_;
+    std::size_t map_size_;
+    int size_;
+    FieldType type_;
+    FieldEntity entity_;
+    const void* values_;
+};
+
+
+/// Read-only, memory-mapped ASCII file of whitespace separated numbers.
+///
+/// The file is split into chunks at whitespace, and the chunks are counted
+/// and parsed in parallel straight into the caller's array. Numbers are
+/// parsed exactly as strtod() and strtol() would in the C locale.
+class AsciiFile
+{
+public:
+    /// Maps the file and counts its numbers.
+    explicit AsciiFile(const std::string& filename);
+    ~AsciiFile();
+
+    AsciiFile(const AsciiFile&) = delete;
+    AsciiFile& operator=(const AsciiFile&) = delete;
+
+    /// Number of whitespace separated tokens in the file.
+    int size() const;
+
+    /// Parses all numbers to out, which must have room for size() values.
+    /// Throws if a token is not a number.
+    void parseTo(double* out) const;
+
+    /// Parses all integers to out, as parseTo(double*).
+    void parseTo(int* out) const;
+
+private:
+    template <typename T>
+    void parseChunks(T* out) const;
+
+    std::string filename_;
+    char* map_;
+    std::size_t map_size_;
+    /// Chunk c is the bytes chunk_start_[c] to chunk_start_[c + 1], and its
+    /// first number is number chunk_offset_[c] of the file.
+    std::vector<std::size_t> chunk_start_;
+    std::vector<int> chunk_offset_;
+};
+
+
+/// True if an input file should be read as a field file. The format is
+/// the value of the input's <name>_format parameter: "binary", "ascii"
+/// or "auto", which picks binary for filenames ending in .eqf. Throws for
+/// other formats.
+bool isBinaryInput(const std::string& format, const std::string& filename);
+
+} // namespace equelle
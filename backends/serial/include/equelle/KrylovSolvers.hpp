@@ -0,0 +1,256 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <limits>
+
+namespace equelle {
+
+/// Outcome of an iterative linear solve.
+struct KrylovReport
+{
+    bool converged;
+    int iterations;
+    /// Final residual norm relative to the norm of the right hand side.
+    double residual_reduction;
+};
+
+
+/// Right preconditioned BiCGStab for A x = b. The operator must have a
+/// member multiply(x, y) computing y = A x, and the preconditioner a
+/// member apply(r, z) computing z = M^{-1} r, on raw arrays. Iterates
+/// until |b - A x| <= tol |b|, starting from the x given. When the shadow
+/// residual becomes (nearly) orthogonal to r or to A M^{-1} p, the
+/// iteration is restarted with the current residual as shadow residual.
+template <class Operator, class Precond>
+KrylovReport bicgstab(const Operator& A, const Precond& M,
+                      const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                      const double tol, const int max_iter)
+{
+    const int n = b.size();
+    const double eps = std::numeric_limits<double>::epsilon();
+    KrylovReport rep = { false, 0, 0.0 };
+    const double bnorm = b.norm();
+    if (bnorm == 0.0) {
+        x.setZero();
+        rep.converged = true;
+        return rep;
+    }
+    Eigen::VectorXd r(n);
+    A.multiply(x.data(), r.data());
+    r = b - r;
+    Eigen::VectorXd r0 = r;
+    Eigen::VectorXd p = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd v = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd phat(n);
+    Eigen::VectorXd s(n);
+    Eigen::VectorXd shat(n);
+    Eigen::VectorXd t(n);
+    double rho = 1.0;
+    double alpha = 1.0;
+    double omega = 1.0;
+    double rnorm = r.norm();
+    bool restart = false;
+    // Whether r0 is the current residual, so that a restart does not help.
+    bool fresh = true;
+    while (rnorm > tol * bnorm && rep.iterations < max_iter) {
+        double rho_new = r0.dot(r);
+        if (restart || omega == 0.0 || std::fabs(rho_new) <= eps * r0.norm() * rnorm) {
+            // Breakdown: restart with r as shadow residual.
+            r0 = r;
+            rho_new = rnorm * rnorm;
+            rho = 1.0;
+            alpha = 1.0;
+            omega = 1.0;
+            p.setZero();
+            v.setZero();
+            restart = false;
+            fresh = true;
+        }
+        const double beta = (rho_new / rho) * (alpha / omega);
+        p = r + beta * (p - omega * v);
+        M.apply(p.data(), phat.data());
+        A.multiply(phat.data(), v.data());
+        ++rep.iterations;
+        const double r0v = r0.dot(v);
+        if (std::fabs(r0v) <= eps * r0.norm() * v.norm()) {
+            if (fresh) {
+                break; // Breakdown, r is orthogonal to A M^{-1} r.
+            }
+            restart = true;
+            continue;
+        }
+        fresh = false;
+        alpha = rho_new / r0v;
+        s = r - alpha * v;
+        if (s.norm() <= tol * bnorm) {
+            x += alpha * phat;
+            rnorm = s.norm();
+            break;
+        }
+        M.apply(s.data(), shat.data());
+        A.multiply(shat.data(), t.data());
+        const double tt = t.squaredNorm();
+        omega = tt > 0.0 ? t.dot(s) / tt : 0.0;
+        x += alpha * phat + omega * shat;
+        r = s - omega * t;
+        rnorm = r.norm();
+        rho = rho_new;
+    }
+    rep.residual_reduction = rnorm / bnorm;
+    rep.converged = std::isfinite(rnorm) && rnorm <= tol * bnorm;
+    return rep;
+}
+
+
+/// Preconditioned conjugate gradients for A x = b, for symmetric
+/// positive definite A and M. Requirements and stopping criterion as for
+/// bicgstab().
+template <class Operator, class Precond>
+KrylovReport cg(const Operator& A, const Precond& M,
+                const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                const double tol, const int max_iter)
+{
+    const int n = b.size();
+    KrylovReport rep = { false, 0, 0.0 };
+    const double bnorm = b.norm();
+    if (bnorm == 0.0) {
+        x.setZero();
+        rep.converged = true;
+        return rep;
+    }
+    Eigen::VectorXd r(n);
+    A.multiply(x.data(), r.data());
+    r = b - r;
+    Eigen::VectorXd z(n);
+    M.apply(r.data(), z.data());
+    Eigen::VectorXd p = z;
+    Eigen::VectorXd q(n);
+    double rz = r.dot(z);
+    double rnorm = r.norm();
+    while (rnorm > tol * bnorm && rep.iterations < max_iter) {
+        A.multiply(p.data(), q.data());
+        const double pq = p.dot(q);
+        if (pq == 0.0) {
+            break; // Breakdown.
+        }
+        const double alpha = rz / pq;
+        x += alpha * p;
+        r -= alpha * q;
+        rnorm = r.norm();
+        ++rep.iterations;
+        M.apply(r.data(), z.data());
+        const double rz_new = r.dot(z);
+        p = z + (rz_new / rz) * p;
+        rz = rz_new;
+    }
+    rep.residual_reduction = rnorm / bnorm;
+    rep.converged = std::isfinite(rnorm) && rnorm <= tol * bnorm;
+    return rep;
+}
+
+
+/// Right preconditioned GMRES for A x = b, restarted after every restart
+/// iterations. Requirements and stopping criterion as for bicgstab().
+/// Stops early at a breakdown, which only happens if A or M is singular.
+template <class Operator, class Precond>
+KrylovReport gmres(const Operator& A, const Precond& M,
+                   const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                   const double tol, const int max_iter, const int restart)
+{
+    const int n = b.size();
+    const int m = restart;
+    KrylovReport rep = { false, 0, 0.0 };
+    const double bnorm = b.norm();
+    if (bnorm == 0.0) {
+        x.setZero();
+        rep.converged = true;
+        return rep;
+    }
+    Eigen::MatrixXd V(n, m + 1);
+    Eigen::MatrixXd H = Eigen::MatrixXd::Zero(m + 1, m);
+    Eigen::VectorXd cs(m);
+    Eigen::VectorXd sn(m);
+    Eigen::VectorXd g(m + 1);
+    Eigen::VectorXd r(n);
+    Eigen::VectorXd w(n);
+    Eigen::VectorXd z(n);
+    double rnorm = 0.0;
+    for (;;) {
+        A.multiply(x.data(), r.data());
+        r = b - r;
+        rnorm = r.norm();
+        if (rnorm <= tol * bnorm || rep.iterations >= max_iter) {
+            break;
+        }
+        V.col(0) = r / rnorm;
+        g.setZero();
+        g[0] = rnorm;
+        int k = 0;
+        bool breakdown = false;
+        while (k < m && rep.iterations < max_iter) {
+            M.apply(V.col(k).data(), z.data());
+            A.multiply(z.data(), w.data());
+            // Modified Gram-Schmidt.
+            for (int i = 0; i <= k; ++i) {
+                H(i, k) = w.dot(V.col(i));
+                w -= H(i, k) * V.col(i);
+            }
+            H(k + 1, k) = w.norm();
+            if (H(k + 1, k) != 0.0) {
+                V.col(k + 1) = w / H(k + 1, k);
+            }
+            // Reduce H to upper triangular form with Givens rotations.
+            for (int i = 0; i < k; ++i) {
+                const double tmp = cs[i] * H(i, k) + sn[i] * H(i + 1, k);
+                H(i + 1, k) = -sn[i] * H(i, k) + cs[i] * H(i + 1, k);
+                H(i, k) = tmp;
+            }
+            const double h = std::hypot(H(k, k), H(k + 1, k));
+            ++rep.iterations;
+            if (h == 0.0) {
+                // Breakdown: the new direction is in the span of the
+                // previous ones, but does not reduce the residual, and
+                // would make the triangular system singular. Use the
+                // previous directions only.
+                breakdown = true;
+                break;
+            }
+            cs[k] = H(k, k) / h;
+            sn[k] = H(k + 1, k) / h;
+            H(k, k) = h;
+            H(k + 1, k) = 0.0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            ++k;
+            if (std::fabs(g[k]) <= tol * bnorm) {
+                break;
+            }
+        }
+        // Update x with the minimizer in the Krylov space.
+        if (k > 0) {
+            const Eigen::VectorXd y = H.topLeftCorner(k, k).triangularView<Eigen::Upper>().solve(g.head(k));
+            const Eigen::VectorXd vy = V.leftCols(k) * y;
+            M.apply(vy.data(), z.data());
+            x += z;
+        }
+        if (breakdown) {
+            // The Krylov space holds no better solution, report the
+            // residual reached.
+            A.multiply(x.data(), r.data());
+            r = b - r;
+            rnorm = r.norm();
+            break;
+        }
+    }
+    rep.residual_reduction = rnorm / bnorm;
+    rep.converged = std::isfinite(rnorm) && rnorm <= tol * bnorm;
+    return rep;
+}
+
+} // namespace equelle
@@ -0,0 +1,318 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/grid/utility/StopWatch.hpp>
+
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "equelle/equelleTypes.hpp"
+#include "equelle/AutoDiffKernels.hpp"
+#include "equelle/BlockCsrMatrix.hpp"
+#include "equelle/Preconditioners.hpp"
+#include "equelle/KrylovSolvers.hpp"
+
+namespace equelle {
+
+/// Solver for the linear systems of newtonSolve().
+///
+/// The jacobians of successive Newton iterations (and usually of
+/// successive timesteps) have the same sparsity pattern. The solver keeps
+/// the last matrix in persistent storage, and as long as the pattern is
+/// unchanged only the values are refilled, so neither the compressed
+/// row storage nor the symbolic analysis of a direct solver is rebuilt.
+///
+/// The method is chosen by the "solver" parameter:
+///   - opm (default): Opm::LinearSolverFactory, configured by its own
+///     parameters (linsolver etc.), given the persistent CSR matrix.
+///   - SparseLU: Eigen's sparse LU factorization, reusing the fill
+///     reducing ordering and symbolic analysis while the pattern is
+///     unchanged.
+///   - CG, BiCGStab or GMRes: the native Krylov solvers of
+///     KrylovSolvers.hpp on the matrix in block compressed row storage
+///     (BlockCsrMatrix), with one block per element holding all
+///     equations and unknowns of a system. The "preconditioner"
+///     parameter is ILU0 (default) for block ILU(0), Jacobi for block
+///     Jacobi, AMG for aggregation multigrid or none. The iteration stops
+///     when the residual is reduced by "solver_tol" (default 1e-8) or
+///     after "solver_max_iter" (default 1000) iterations, and GMRes
+///     restarts every "gmres_restart" (default 30) iterations. CG
+///     requires a symmetric positive definite jacobian.
+///
+/// The Krylov solvers start from the solution of the previous solve,
+/// normally the previous Newton update, unless it gives a larger initial
+/// residual than a zero guess or "initial_guess" is zero rather than
+/// previous (default).
+///
+/// Jacobian-free solves (solveJacobianFree()) use the Krylov method of
+/// "solver", or GMRes for a direct solver, with the same tolerances. The
+/// "jfnk_preconditioner" parameter is none (default), Jacobi, ILU0 or
+/// AMG, the latter three set up from an assembled jacobian as for the
+/// Krylov solvers.
+///
+/// With "preconditioner_rebuild_iterations" set to a positive n, the
+/// preconditioner is kept from one solve to the next, and only set up
+/// again when the pattern changes or the previous solve took more than n
+/// iterations. A solve that does not converge in n iterations with a
+/// kept preconditioner is restarted with a new one. The default, 0, sets
+/// it up for every solve.
+///
+/// Each parameter can be given with the prefix of the constructor, for
+/// instance newton2_solver for the solver with prefix "newton2_", which
+/// takes precedence over the parameter without prefix. The parameters of
+/// the opm solver cannot be prefixed.
+class LinearSolver
+{
+public:
+    /// Constructor, reading the parameters described above.
+    explicit LinearSolver(const Opm::ParameterGroup& param,
+                          const std::string& prefix = "");
+
+    /// Solves jacobian * x = rhs. Throws if the solver fails.
+    /// The jacobian is swapped into persistent storage, and on return
+    /// holds the storage of the previous matrix for reuse by the caller.
+    /// The block size is the number of unknowns of a system with
+    /// unknowns of equal size, see BlockCsrMatrix, and 1 otherwise.
+    void solve(SparseColMajor& jacobian,
+               const CollOfScalar::V& rhs,
+               CollOfScalar::V& x,
+               const int block_size = 1);
+
+    /// Solves J x = rhs, where J is only available through apply(v, jv)
+    /// computing jv = J v for CollOfScalar::V vectors v and jv. When the
+    /// preconditioner is to be set up, assemble(jacobian) is called to
+    /// assemble J into a SparseColMajor, whose storage is recycled as in
+    /// solve(). Without a preconditioner it is never called.
+    template <class Apply, class Assemble>
+    void solveJacobianFree(const Apply& apply,
+                           const Assemble& assemble,
+                           const CollOfScalar::V& rhs,
+                           CollOfScalar::V& x,
+                           const int block_size = 1);
+
+    /// Relative residual reduction required of iterative methods. Direct
+    /// methods ignore it. It starts at solver_tol, or for the opm solver
+    /// at the tolerance the OPM solver is configured with.
+    void setTolerance(const double tol);
+    double tolerance() const;
+
+    /// Number of iterations used by the last solve, 1 for direct methods.
+    int lastIterations() const;
+
+    /// Seconds spent in the last solve setting up preconditioners, or
+    /// factorizing for SparseLU. Unknown, and 0, for the opm solver.
+    double lastSetupTime() const;
+
+    /// Number of solves that reused the pattern of the previous matrix.
+    int patternReuses() const;
+
+    /// Number of solves that had to set up a new pattern.
+    int patternRebuilds() const;
+
+    /// Number of preconditioner setups.
+    int preconditionerSetups() const;
+
+    /// Number of solves that kept the preconditioner of the previous one.
+    int preconditionerReuses() const;
+
+private:
+    typedef Eigen::SparseMatrix<double, Eigen::RowMajor> RowMajorMatrix;
+    enum Method { OpmFactory, SparseLU, Krylov };
+    enum KrylovMethod { CG, BiCGStab, GMRes };
+
+    /// Returns true if the pattern of matrix_ or the block size differs
+    /// from the one of the previous call.
+    bool updatePattern(const int block_size);
+
+    /// True if the preconditioner of the previous solve can be kept for
+    /// a matrix of size rows, with new_pattern telling if its pattern
+    /// has changed.
+    bool preconditionerReusable(const bool new_pattern, const int size) const;
+
+    /// Sets up prec for bsr_, counting the setup.
+    void setupPreconditioner(Preconditioner& prec);
+
+    /// Runs the Krylov method of krylov_ for op x = b from the x given,
+    /// for at most max_iter iterations.
+    template <class Operator, class Precond>
+    KrylovReport krylovSolve(const Operator& op, const Precond& prec,
+                             const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                             const int max_iter) const;
+
+    /// Replaces the initial guess x for op x = b by zero if that gives
+    /// a smaller residual.
+    template <class Operator>
+    void checkInitialGuess(const Operator& op, const Eigen::VectorXd& b, Eigen::VectorXd& x) const;
+
+    /// Operator for the Krylov solvers computing J v with apply().
+    template <class Apply>
+    struct JacobianFreeOperator
+    {
+        const Apply& apply;
+        int size;
+        void multiply(const double* x, double* y) const
+        {
+            const CollOfScalar::V v = Eigen::Map<const CollOfScalar::V>(x, size);
+            CollOfScalar::V jv;
+            apply(v, jv);
+            Eigen::Map<CollOfScalar::V>(y, size) = jv;
+        }
+    };
+
+    /// Preconditioner for the Krylov solvers in Jacobian-free solves.
+    struct JacobianFreePreconditioner
+    {
+        const LinearSolver& solver;
+        int size;
+        void apply(const double* r, double* z) const
+        {
+            solver.applyJacobianFreePreconditioner(r, z, size);
+        }
+    };
+
+    /// Sets up jfnk_preconditioner_ for the jacobian, whose storage is
+    /// recycled as in solve().
+    void setupJacobianFreePreconditioner(SparseColMajor& jacobian, const int block_size);
+
+    /// z = M^{-1} r for vectors of size n ordered by unknown, with the
+    /// identity for M if there is no Jacobian-free preconditioner.
+    void applyJacobianFreePreconditioner(const double* r, double* z, const int n) const;
+
+    /// Sets up csr_ and csr_position_ for the pattern of matrix_.
+    void buildCsrPattern();
+
+    /// Copies the values of matrix_ into csr_.
+    void refillCsrValues();
+
+    Method method_;
+    KrylovMethod krylov_;
+    std::unique_ptr<Opm::LinearSolverFactory> opm_solver_;
+    Eigen::SparseLU<SparseColMajor, Eigen::COLAMDOrdering<int> > lu_;
+    std::unique_ptr<Preconditioner> preconditioner_;
+    std::unique_ptr<Preconditioner> jfnk_preconditioner_;
+    // Vectors in block order for applyJacobianFreePreconditioner().
+    mutable std::vector<double> r_block_;
+    mutable std::vector<double> z_block_;
+    double tol_;
+    int max_iter_;
+    int restart_;
+    int rebuild_iterations_;
+    // True if the preconditioner has been set up for the current pattern.
+    bool preconditioner_current_;
+    // Solution of the previous solve, ordered by unknown, if warm_start_.
+    bool warm_start_;
+    CollOfScalar::V previous_solution_;
+    // The current matrix, in the column major format of the jacobians.
+    SparseColMajor matrix_;
+    // Pattern of the previous matrix.
+    int pattern_rows_;
+    int pattern_block_size_;
+    std::vector<int> pattern_outer_;
+    std::vector<int> pattern_inner_;
+    // The current matrix in compressed row storage, and for each entry
+    // of matrix_ its position in csr_.
+    RowMajorMatrix csr_;
+    std::vector<int> csr_position_;
+    // The current matrix in block compressed row storage.
+    BlockCsrMatrix bsr_;
+    int last_iterations_;
+    // Iterations of the last solve with the current preconditioner, not
+    // counting a failed attempt with the previous one. Decides if the
+    // preconditioner is kept.
+    int preconditioner_iterations_;
+    double last_setup_time_;
+    int pattern_reuses_;
+    int pattern_rebuilds_;
+    int preconditioner_setups_;
+    int preconditioner_reuses_;
+};
+
+
+
+template <class Apply, class Assemble>
+void LinearSolver::solveJacobianFree(const Apply& apply,
+                                     const Assemble& assemble,
+                                     const CollOfScalar::V& rhs,
+                                     CollOfScalar::V& x,
+                                     const int block_size)
+{
+    const int n = rhs.size();
+    last_setup_time_ = 0.0;
+    const bool reuse = jfnk_preconditioner_ && preconditionerReusable(false, n);
+    SparseColMajor jacobian;
+    if (reuse) {
+        ++preconditioner_reuses_;
+    } else if (jfnk_preconditioner_) {
+        assemble(jacobian);
+        setupJacobianFreePreconditioner(jacobian, block_size);
+    }
+    const Eigen::VectorXd b = rhs.matrix();
+    const JacobianFreeOperator<Apply> op = { apply, n };
+    const JacobianFreePreconditioner prec = { *this, n };
+    Eigen::VectorXd z = Eigen::VectorXd::Zero(n);
+    if (warm_start_ && previous_solution_.size() == n) {
+        z = previous_solution_.matrix();
+        checkInitialGuess(op, b, z);
+    }
+    const Eigen::VectorXd z0 = z;
+    KrylovReport rep = krylovSolve(op, prec, b, z, reuse ? rebuild_iterations_ : max_iter_);
+    last_iterations_ = rep.iterations;
+    preconditioner_iterations_ = rep.iterations;
+    if (!rep.converged && reuse) {
+        // The kept preconditioner is too far off, start over with a new one.
+        assemble(jacobian);
+        setupJacobianFreePreconditioner(jacobian, block_size);
+        z = z0;
+        rep = krylovSolve(op, prec, b, z, max_iter_);
+        last_iterations_ += rep.iterations;
+        preconditioner_iterations_ = rep.iterations;
+    }
+    if (!rep.converged) {
+        OPM_THROW(std::runtime_error, "Jacobian-free linear solver convergence failure, residual reduced by "
+                  << rep.residual_reduction << " in " << rep.iterations << " iterations.");
+    }
+    x = z.array();
+    if (warm_start_) {
+        previous_solution_ = x;
+    }
+}
+
+
+template <class Operator, class Precond>
+KrylovReport LinearSolver::krylovSolve(const Operator& op, const Precond& prec,
+                                       const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                                       const int max_iter) const
+{
+    switch (krylov_) {
+    case CG:
+        return cg(op, prec, b, x, tol_, max_iter);
+    case GMRes:
+        return gmres(op, prec, b, x, tol_, max_iter, restart_);
+    default:
+        return bicgstab(op, prec, b, x, tol_, max_iter);
+    }
+}
+
+
+template <class Operator>
+void LinearSolver::checkInitialGuess(const Operator& op, const Eigen::VectorXd& b, Eigen::VectorXd& x) const
+{
+    Eigen::VectorXd r(b.size());
+    op.multiply(x.data(), r.data());
+    if ((b - r).norm() >= b.norm()) {
+        x.setZero();
+    }
+}
+
+} // namespace equelle
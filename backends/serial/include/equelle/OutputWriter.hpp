@@ -0,0 +1,179 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace equelle {
+
+/// Writes the collections given to output() to file, in the format given
+/// by the output_format parameter:
+///
+///   ascii       One text file per call, <tag>-<step>.output, with one
+///               value per line. This is the default.
+///   binary      Records appended to container files kept open for the
+///               whole run, with large buffered writes.
+///   compressed  As binary, with each record deflated by zlib.
+///   xdmf        As binary, plus the grid in grid.bin, written once, and
+///               output.xmf, an XDMF file for ParaView and VisIt. It
+///               references the grid and the records by byte offset, so
+///               nothing is converted or copied. output.xmf has one grid
+///               per step, with the collections of all cells output in
+///               that step as cell attributes; other collections are only
+///               in the containers. It is rewritten by flush().
+///
+/// With output_container=tag (the default) each tag has its own container
+/// <tag>.eqo; with output_container=run all tags go to output.eqo.
+///
+/// nextStep() selects which outputs are written, before any data is
+/// copied. Steps count the output() calls of each tag from 0, and step s
+/// is written if
+///   - the tag is in the comma separated list output_tags (default all),
+///   - s is a multiple of output_every_<tag> (default output_every, 1),
+///   - at least output_time_interval seconds of wall time (default 0)
+///     have passed since the last written step of the tag.
+///
+/// With output_async=true, write() only copies the values to a queue of
+/// at most output_queue_size (default 4) collections, and a writer thread
+/// writes them while the simulation goes on. write() waits for room in
+/// a full queue, and flush() waits for the queue to empty.
+///
+/// A container is a 16 byte header followed by records, in the byte
+/// order of the machine that wrote them:
+///
+///     header  8  magic "EQLOUTPT"
+///             4  uint32 version, currently 1
+///             4  uint32 compression, 0 for none and 1 for zlib
+///     record  4  uint32 step
+///             4  uint32 tag length t
+///             8  uint64 number of values n
+///             8  uint64 number of stored bytes b
+///             t  tag, padded with zeros to a multiple of 8 bytes
+///             b  n doubles, deflated if compressed
+///
+/// Next to each container, <container>.index has one line per record,
+/// "tag step offset n", where offset is the position of the record.
+class OutputWriter
+{
+public:
+    /// The grid is used by the xdmf format.
+    OutputWriter(const Opm::ParameterGroup& param, const UnstructuredGrid& grid);
+
+    /// Writes what is queued, and flushes and closes all containers.
+    /// Errors are lost; call flush() first to see them.
+    ~OutputWriter();
+
+    /// Counts an output of tag, and returns its step if it should be
+    /// written, or -1 if not.
+    int nextStep(const std::string& tag);
+
+    /// Writes (or queues) a step of tag. Throws errors of earlier queued
+    /// writes.
+    void write(const std::string& tag, const int step, const double* values, const int n);
+
+    /// Writes all queued steps and flushes the buffered records of all
+    /// containers to their files. Throws errors of queued writes.
+    void flush();
+
+    /// Replaces the grid written by the xdmf format, which must have
+    /// a cell for each value of the cell collections. Used by the MPI
+    /// backend, whose outputs are gathered on the global grid. Must be
+    /// called before the first write().
+    void setGrid(const UnstructuredGrid& grid);
+
+private:
+    struct Record
+    {
+        std::string tag;
+        int step;
+        std::vector<double> values;
+    };
+
+    /// A record of a collection of all cells, for output.xmf.
+    struct CellField
+    {
+        std::string tag;
+        int step;
+        std::string container;
+        std::uint64_t seek;
+    };
+
+    struct TagSelection
+    {
+        int calls;
+        int every;
+        bool listed;
+        bool written;
+        std::chrono::steady_clock::time_point last_written;
+    };
+
+    struct Container
+    {
+        // The buffers must outlive the streams using them.
+        std::vector<char> file_buffer;
+        std::vector<char> index_buffer;
+        std::ofstream file;
+        std::ofstream index;
+        std::string name;
+        std::uint64_t offset;
+    };
+
+    void writeRecord(const std::string& tag, const int step, const double* values, const int n);
+    void writerLoop();
+    void rethrowWriterError();
+    void flushFiles();
+    void writeGrid();
+    void writeXdmf() const;
+    void writeAscii(const std::string& tag, const int step,
+                    const double* values, const int n) const;
+    Container& container(const std::string& tag);
+
+    // For nextStep(), only used by the caller's thread.
+    const Opm::ParameterGroup& param_;
+    std::set<std::string> tags_;
+    int every_;
+    double time_interval_;
+    std::map<std::string, TagSelection> selection_;
+    // For writeRecord(). Only used by the writer thread while it runs,
+    // or while the queue is empty and it is idle.
+    enum Format { Ascii, Binary, Compressed, Xdmf };
+    Format format_;
+    bool container_per_tag_;
+    std::map<std::string, std::unique_ptr<Container> > containers_;
+    std::vector<unsigned char> deflated_;
+    const UnstructuredGrid* grid_;
+    // Sizes of the two parts of grid.bin, the node coordinates and the
+    // XDMF Mixed topology, or 0 before it is written.
+    std::uint64_t grid_coordinate_count_;
+    std::uint64_t grid_topology_count_;
+    std::vector<CellField> cell_fields_;
+    // For output_async.
+    bool async_;
+    int queue_limit_;
+    std::deque<Record> queue_;
+    bool writing_;
+    bool stop_;
+    std::exception_ptr writer_error_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::thread writer_;
+};
+
+} // namespace equelle
@@ -0,0 +1,108 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+#include "equelle/BlockCsrMatrix.hpp"
+
+namespace equelle {
+
+/// Interface for preconditioners of the iterative linear solvers.
+/// All vectors are in the block order of the BlockCsrMatrix.
+class Preconditioner
+{
+public:
+    virtual ~Preconditioner() {}
+
+    /// Computes the preconditioner for the current values of a.
+    virtual void setup(const BlockCsrMatrix& a) = 0;
+
+    /// z = M^{-1} r.
+    virtual void apply(const double* r, double* z) const = 0;
+};
+
+
+/// No preconditioning, z = r.
+class IdentityPreconditioner : public Preconditioner
+{
+public:
+    void setup(const BlockCsrMatrix& a);
+    void apply(const double* r, double* z) const;
+
+private:
+    int size_;
+};
+
+
+/// Block Jacobi: multiplies by the inverses of the diagonal blocks.
+class BlockJacobiPreconditioner : public Preconditioner
+{
+public:
+    void setup(const BlockCsrMatrix& a);
+    void apply(const double* r, double* z) const;
+
+private:
+    int block_size_;
+    int block_rows_;
+    std::vector<double> inv_diag_;
+};
+
+
+/// Block ILU(0): incomplete LU factorization with the block pattern of
+/// the matrix, using dense block arithmetic. With block size 1 this is
+/// the ordinary ILU(0).
+class BlockILU0Preconditioner : public Preconditioner
+{
+public:
+    void setup(const BlockCsrMatrix& a);
+    void apply(const double* r, double* z) const;
+
+private:
+    const BlockCsrMatrix* a_;
+    // Factors in the pattern of a_, strictly lower part L with unit
+    // diagonal and upper part U, and the inverted diagonal blocks of U.
+    std::vector<double> lu_;
+    std::vector<double> inv_diag_;
+};
+
+
+/// Algebraic multigrid with plain aggregation of block rows. Each block
+/// row is aggregated with its strongly coupled neighbours, measuring
+/// blocks by their Frobenius norm, and the coarse matrices are the
+/// Galerkin products with the piecewise constant prolongation. Applying
+/// the preconditioner is one V-cycle with a damped block Jacobi sweep
+/// before and after each coarse correction, and a dense LU solve on a
+/// small enough coarsest level.
+class AMGPreconditioner : public Preconditioner
+{
+public:
+    void setup(const BlockCsrMatrix& a);
+    void apply(const double* r, double* z) const;
+
+    /// Number of levels of the last setup, including the finest.
+    int levels() const;
+
+private:
+    void cycle(const int level) const;
+
+    // Matrices of all levels, the finest being the one given to setup().
+    std::vector<const BlockCsrMatrix*> a_;
+    std::vector<BlockCsrMatrix> coarse_;
+    // Coarse block row of each block row, for all but the coarsest level.
+    std::vector<std::vector<int> > aggregate_;
+    std::vector<BlockJacobiPreconditioner> smoother_;
+    bool direct_coarse_;
+    Eigen::FullPivLU<Eigen::MatrixXd> coarse_lu_;
+    // Solution, right hand side and work vectors of each level.
+    mutable std::vector<Eigen::VectorXd> x_;
+    mutable std::vector<Eigen::VectorXd> b_;
+    mutable std::vector<Eigen::VectorXd> r_;
+    mutable std::vector<Eigen::VectorXd> t_;
+};
+
+} // namespace equelle
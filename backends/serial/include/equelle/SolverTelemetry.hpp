@@ -0,0 +1,77 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace equelle {
+
+/// Measurements of one Newton iteration. Iteration 0 is the evaluation
+/// of the initial guess, with no linear solve.
+struct NewtonIterationRecord
+{
+    /// Two-norm of the residual after the iteration.
+    double residual_norm;
+    int linear_iterations;
+    /// Seconds spent evaluating residuals and jacobians, including
+    /// line search evaluations.
+    double assembly_time;
+    /// Seconds spent in the linear solver, including setup_time.
+    double solve_time;
+    /// Seconds spent setting up preconditioners or factorizing.
+    double setup_time;
+};
+
+
+/// Measurements of one call of newtonSolve() or newtonSolveSystem(),
+/// normally one per timestep and call site.
+struct NewtonSolveRecord
+{
+    /// Call site of the solve, see EquelleRuntimeCPU::newtonSolve().
+    int site;
+    bool converged;
+    /// Total seconds spent in the solve.
+    double time;
+    std::vector<NewtonIterationRecord> iterations;
+
+    /// Number of Newton iterations, not counting iteration 0.
+    int newtonIterations() const;
+
+    /// Sum of the linear iterations over all Newton iterations.
+    int linearIterations() const;
+};
+
+
+/// Accumulates the records of all Newton solves of a run, and writes
+/// them as CSV or JSON.
+class SolverTelemetry
+{
+public:
+    /// Adds the record of a finished solve.
+    void add(const NewtonSolveRecord& record);
+
+    /// All records, in the order the solves finished.
+    const std::vector<NewtonSolveRecord>& records() const;
+
+    /// Writes one line per Newton iteration, with the columns
+    /// solve,site,converged,iteration,residual_norm,linear_iterations,
+    /// assembly_time,solve_time,setup_time. Solves are numbered from 0.
+    void writeCsv(std::ostream& os) const;
+
+    /// Writes an array with one object per solve, holding its site,
+    /// convergence, time and an array of its iterations.
+    void writeJson(std::ostream& os) const;
+
+    /// Writes the records to the named file with writeCsv() if the
+    /// name ends with .csv, and with writeJson() otherwise.
+    void write(const std::string& filename) const;
+
+private:
+    std::vector<NewtonSolveRecord> records_;
+};
+
+} // namespace equelle
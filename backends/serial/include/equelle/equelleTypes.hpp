@@ -6,6 +6,14 @@
 
 #include <vector>
 #include <string>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
 
 namespace equelle {
 
@@ -29,9 +37,221 @@ typedef TopologicalEntity<0> Cell;
 /// Topological entity for cell.
 typedef TopologicalEntity<1> Face;
 
+/// Returns a new, unique identity for a topological collection.
+inline std::uint64_t nextCollectionId()
+{
+    static std::atomic<std::uint64_t> next_id(1);
+    return next_id++;
+}
+
+/// Collection of topological entities.
+/// A collection either stores its entities explicitly, or it is the
+/// full set of all entities of its kind in the grid (as returned by
+/// AllCells() and AllFaces()). A full collection only stores its size,
+/// much like the CUDA backend's CollOfIndices, and entity i of a full
+/// collection is simply entity number i in the grid.
+///
+/// Explicitly stored entities are shared between copies of a collection
+/// (copy-on-write), and each stored set of entities has an identity,
+/// id(), that is shared by copies and renewed by any modification. This
+/// allows the runtime to cache data that depends only on the contents
+/// of a collection, such as the index maps used by operatorOn().
+///
+/// The interface mimics std::vector, but elements are only read by
+/// value, and written with set(), push_back() and emplace_back(). No
+/// references into the (possibly shared) entities are handed out, so
+/// that every modification goes through a function that makes a private
+/// copy of shared entities and renews the identity. Modifying a full
+/// collection converts it to an explicitly stored one.
+template <int Codim>
+class TopologicalCollection
+{
+public:
+    typedef TopologicalEntity<Codim> value_type;
+
+    /// Iterator for read-only traversal, valid for both full and
+    /// explicitly stored collections. Dereferencing yields an entity by value.
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef TopologicalEntity<Codim> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type reference;
+
+        const_iterator() : coll_(nullptr), pos_(0) {}
+        const_iterator(const TopologicalCollection* coll, const int pos) : coll_(coll), pos_(pos) {}
+        reference operator*() const { return (*coll_)[pos_]; }
+        reference operator[](const difference_type n) const { return (*coll_)[pos_ + n]; }
+        const_iterator& operator++() { ++pos_; return *this; }
+        const_iterator operator++(int) { const_iterator before(*this); ++pos_; return before; }
+        const_iterator& operator--() { --pos_; return *this; }
+        const_iterator operator--(int) { const_iterator before(*this); --pos_; return before; }
+        const_iterator& operator+=(const difference_type n) { pos_ += n; return *this; }
+        const_iterator& operator-=(const difference_type n) { pos_ -= n; return *this; }
+        const_iterator operator+(const difference_type n) const { return const_iterator(coll_, pos_ + n); }
+        const_iterator operator-(const difference_type n) const { return const_iterator(coll_, pos_ - n); }
+        difference_type operator-(const const_iterator& rhs) const { return pos_ - rhs.pos_; }
+        bool operator==(const const_iterator& rhs) const { return pos_ == rhs.pos_; }
+        bool operator!=(const const_iterator& rhs) const { return pos_ != rhs.pos_; }
+        bool operator<(const const_iterator& rhs) const { return pos_ < rhs.pos_; }
+        bool operator>(const const_iterator& rhs) const { return pos_ > rhs.pos_; }
+        bool operator<=(const const_iterator& rhs) const { return pos_ <= rhs.pos_; }
+        bool operator>=(const const_iterator& rhs) const { return pos_ >= rhs.pos_; }
+    private:
+        const TopologicalCollection* coll_;
+        int pos_;
+    };
+
+    /// Construct an empty collection.
+    TopologicalCollection()
+        : full_(false),
+          size_(0),
+          id_(0)
+    {
+    }
+
+    /// Construct a collection of n empty (index -1) entities.
+    explicit TopologicalCollection(const std::size_t n)
+        : full_(false),
+          size_(n),
+          entities_(std::make_shared<std::vector<value_type>>(n)),
+          id_(nextCollectionId())
+    {
+    }
+
+    /// Construct a collection from explicitly given entities.
+    explicit TopologicalCollection(std::vector<value_type> entities)
+        : full_(false),
+          size_(entities.size()),
+          entities_(std::make_shared<std::vector<value_type>>(std::move(entities))),
+          id_(nextCollectionId())
+    {
+    }
+
+    /// Construct the full collection of all n entities, without storage.
+    static TopologicalCollection full(const int n)
+    {
+        TopologicalCollection coll;
+        coll.full_ = true;
+        coll.size_ = n;
+        return coll;
+    }
+
+    /// True if this is the full collection of all entities in the grid.
+    bool isFull() const
+    {
+        return full_;
+    }
+
+    /// Identity of the stored entities, or zero for full and empty
+    /// collections (which have no stored entities).
+    std::uint64_t id() const
+    {
+        return id_;
+    }
+
+    /// Observer of the stored entities. It expires when the last
+    /// collection sharing the storage is destroyed.
+    std::weak_ptr<const void> storage() const
+    {
+        return entities_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /// Entity i, by value. It is const so that assigning to it, which
+    /// would not change the collection, does not compile.
+    const value_type operator[](const std::size_t i) const
+    {
+        assert(i < size_);
+        return full_ ? value_type(i) : (*entities_)[i];
+    }
+
+    /// Replaces entity i.
+    void set(const std::size_t i, const value_type& e)
+    {
+        assert(i < size_);
+        detach();
+        (*entities_)[i] = e;
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, size_);
+    }
+
+    void reserve(const std::size_t n)
+    {
+        detach();
+        entities_->reserve(n);
+    }
+
+    void clear()
+    {
+        full_ = false;
+        size_ = 0;
+        entities_.reset();
+        id_ = 0;
+    }
+
+    void push_back(const value_type& e)
+    {
+        detach();
+        entities_->push_back(e);
+        ++size_;
+    }
+
+    template <class... Args>
+    void emplace_back(Args&&... args)
+    {
+        detach();
+        entities_->emplace_back(std::forward<Args>(args)...);
+        ++size_;
+    }
+
+private:
+    /// Prepare for modification: make sure the entities are explicitly
+    /// stored and not shared with other collections, and renew the identity.
+    void detach()
+    {
+        if (full_) {
+            entities_ = std::make_shared<std::vector<value_type>>(size_);
+            for (std::size_t i = 0; i < size_; ++i) {
+                (*entities_)[i].index = i;
+            }
+            full_ = false;
+        } else if (!entities_) {
+            entities_ = std::make_shared<std::vector<value_type>>();
+        } else if (entities_.use_count() > 1) {
+            entities_ = std::make_shared<std::vector<value_type>>(*entities_);
+        }
+        id_ = nextCollectionId();
+    }
+
+    bool full_;
+    std::size_t size_;
+    std::shared_ptr<std::vector<value_type>> entities_;
+    std::uint64_t id_;
+};
+
 /// Topological collections.
-typedef std::vector<Cell> CollOfCell;
-typedef std::vector<Face> CollOfFace;
+typedef TopologicalCollection<0> CollOfCell;
+typedef TopologicalCollection<1> CollOfFace;
 
 // Basic types. Note that we do not have Vector type defined
 // although the CollOfVector type is.
@@ -81,6 +301,51 @@ public:
         : ADB(ADB::constant(x))
     {
     }
+    template <class Derived,
+              class = typename std::enable_if<std::is_same<typename Derived::Scalar, double>::value>::type>
+    CollOfScalar(const Eigen::ArrayBase<Derived>& x)
+        : ADB(ADB::constant(ADB::V(x)))
+    {
+    }
+};
+
+/// The Collection Of Scalar type for values that need no derivatives.
+/// It is a plain Eigen array, so arithmetic on it is evaluated through
+/// Eigen's expression templates without intermediate temporaries, and
+/// without the bookkeeping of (empty) jacobians done by CollOfScalar.
+/// Converting a CollOfScalar to this type drops its derivatives.
+class CollOfScalarValue : public CollOfScalar::V
+{
+public:
+    typedef CollOfScalar::V V;
+    CollOfScalarValue()
+    {
+    }
+    explicit CollOfScalarValue(const int size)
+        : V(size)
+    {
+    }
+    template <class Derived,
+              class = typename std::enable_if<std::is_same<typename Derived::Scalar, double>::value>::type>
+    CollOfScalarValue(const Eigen::ArrayBase<Derived>& x)
+        : V(x)
+    {
+    }
+    CollOfScalarValue(const CollOfScalar::ADB& x)
+        : V(x.value())
+    {
+    }
+    template <class Derived>
+    CollOfScalarValue& operator=(const Eigen::ArrayBase<Derived>& x)
+    {
+        V::operator=(x);
+        return *this;
+    }
+    /// For code that is generic over CollOfScalar and CollOfScalarValue.
+    const V& value() const
+    {
+        return *this;
+    }
 };
 
 /// This operator is not provided by AutoDiffBlock, so we must add it here.
@@ -89,16 +354,107 @@ inline CollOfScalar operator-(const CollOfScalar& x)
     return CollOfScalar::V::Zero(x.size()) - x;
 }
 
+/// Elementwise product and quotient with jacobians. They compute the
+/// same as the AutoDiffBlock operators, but the diagonal times sparse
+/// products of the jacobians are done by the threaded kernels of
+/// AutoDiffKernels.cpp, where they are defined.
+CollOfScalar multiply(const CollOfScalar::ADB& x, const CollOfScalar::ADB& y);
+CollOfScalar divide(const CollOfScalar::ADB& x, const CollOfScalar::ADB& y);
+
+/// True if Values is an Eigen array or array expression of scalars,
+/// such as CollOfScalarValue, and Coll is a CollOfScalar. The operators
+/// for such operands take both exactly, so that they are preferred to
+/// AutoDiffBlock's operators for arrays, and do not apply to plain
+/// AutoDiffBlocks.
+template <class Values, class Coll>
+struct IsScalarArrayAndCollection
+    : std::integral_constant<bool, std::is_convertible<Values, CollOfScalar::V>::value
+                                   && std::is_base_of<CollOfScalar, Coll>::value>
+{
+};
+
+/// The products and quotients of collections of scalars, with each
+/// other, with AutoDiffBlocks, Eigen arrays and scalars, use multiply()
+/// and divide(). Only products of two plain AutoDiffBlocks, or of a
+/// plain AutoDiffBlock and an array, are left to AutoDiffBlock.
+inline CollOfScalar operator*(const CollOfScalar& x, const CollOfScalar& y)
+{
+    return multiply(x, y);
+}
+
+inline CollOfScalar operator*(const CollOfScalar::ADB& x, const CollOfScalar& y)
+{
+    return multiply(x, y);
+}
+
+inline CollOfScalar operator*(const CollOfScalar& x, const CollOfScalar::ADB& y)
+{
+    return multiply(x, y);
+}
+
+template <class Values, class Coll>
+typename std::enable_if<IsScalarArrayAndCollection<Values, Coll>::value, CollOfScalar>::type
+operator*(const Values& x, const Coll& y)
+{
+    return multiply(CollOfScalar::ADB::constant(x), y);
+}
+
+template <class Coll, class Values>
+typename std::enable_if<IsScalarArrayAndCollection<Values, Coll>::value, CollOfScalar>::type
+operator*(const Coll& x, const Values& y)
+{
+    return multiply(x, CollOfScalar::ADB::constant(y));
+}
+
+inline CollOfScalar operator*(const Scalar& s, const CollOfScalar& x)
+{
+    return multiply(CollOfScalar::ADB::constant(CollOfScalar::V::Constant(x.size(), s)), x);
+}
+
+inline CollOfScalar operator*(const CollOfScalar& x, const Scalar& s)
+{
+    return multiply(x, CollOfScalar::ADB::constant(CollOfScalar::V::Constant(x.size(), s)));
+}
+
+inline CollOfScalar operator/(const CollOfScalar& x, const CollOfScalar& y)
+{
+    return divide(x, y);
+}
+
+inline CollOfScalar operator/(const CollOfScalar::ADB& x, const CollOfScalar& y)
+{
+    return divide(x, y);
+}
+
+inline CollOfScalar operator/(const CollOfScalar& x, const CollOfScalar::ADB& y)
+{
+    return divide(x, y);
+}
+
+template <class Values, class Coll>
+typename std::enable_if<IsScalarArrayAndCollection<Values, Coll>::value, CollOfScalar>::type
+operator/(const Values& x, const Coll& y)
+{
+    return divide(CollOfScalar::ADB::constant(x), y);
+}
+
+template <class Coll, class Values>
+typename std::enable_if<IsScalarArrayAndCollection<Values, Coll>::value, CollOfScalar>::type
+operator/(const Coll& x, const Values& y)
+{
+    return divide(x, CollOfScalar::ADB::constant(y));
+}
+
 /// This operator is not provided by AutoDiffBlock, so we must add it here.
 inline CollOfScalar operator/(const Scalar& s, const CollOfScalar& x)
 {
-    return CollOfScalar::V::Constant(x.size(), s) / x;
+    return divide(CollOfScalar::ADB::constant(CollOfScalar::V::Constant(x.size(), s)), x);
 }
 
 /// This operator is not provided by AutoDiffBlock, so we must add it here.
 inline CollOfScalar operator/(const CollOfScalar& x, const Scalar& s)
 {
-    return x / CollOfScalar::V::Constant(x.size(), s);
+    return divide(x, CollOfScalar::ADB::constant(CollOfScalar::V::Constant(x.size(), s)));
 }
 
 /// This operator is not provided by AutoDiffBlock, so we must add it here.
@@ -191,6 +547,33 @@ inline CollOfBool operator==(const CollOfScalar& x, const CollOfScalar& y)
     return x.value() == y.value();
 }
 
+/// Comparisons with the Scalar on the left for CollOfScalarValue, so
+/// that they do not convert to CollOfScalar.
+inline CollOfBool operator<(const Scalar& s, const CollOfScalarValue& x)
+{
+    return x > s;
+}
+
+inline CollOfBool operator<=(const Scalar& s, const CollOfScalarValue& x)
+{
+    return x >= s;
+}
+
+inline CollOfBool operator>(const Scalar& s, const CollOfScalarValue& x)
+{
+    return x < s;
+}
+
+inline CollOfBool operator>=(const Scalar& s, const CollOfScalarValue& x)
+{
+    return x <= s;
+}
+
+inline CollOfBool operator==(const Scalar& s, const CollOfScalarValue& x)
+{
+    return x == s;
+}
+
 /// This function is not provided by AutoDiffBlock, so we must add it here.
 inline CollOfScalar sqrt(const CollOfScalar& x)
 {
@@ -212,75 +595,136 @@ inline CollOfScalar sqrt(const CollOfScalar& x)
 
 
 
+/// The Collection Of Vector type stores the values of all components
+/// contiguously, as a (size x dim) array with one column per component.
+/// Derivatives are optional and kept per component. If no component
+/// has derivatives, the arithmetic operators work on the whole value
+/// array in a single pass.
 class CollOfVector
 {
 public:
-    explicit CollOfVector(const int columns)
-        : v(columns)
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> Values;
+    typedef std::vector<CollOfScalar::M> Jacobian;
+
+    CollOfVector()
     {
     }
-    const CollOfScalar& col(const int c) const
+    CollOfVector(const int size, const int columns)
+        : values_(Values::Zero(size, columns)),
+          jac_(columns)
     {
-        return v[c];
     }
-    CollOfScalar& col(const int c)
+    explicit CollOfVector(Values values)
+        : values_(std::move(values)),
+          jac_(values_.cols())
     {
-        return v[c];
+    }
+    /// Returns component c, with derivatives if it has any.
+    CollOfScalar col(const int c) const
+    {
+        CollOfScalar::V v = values_.col(c);
+        if (jac_[c].empty()) {
+            return CollOfScalar(v);
+        }
+        Jacobian jac = jac_[c];
+        return CollOfScalar::ADB::function(std::move(v), std::move(jac));
+    }
+    /// Replaces component c, which must have the same size.
+    void setCol(const int c, const CollOfScalar& x)
+    {
+        assert(x.size() == size());
+        values_.col(c) = x.value();
+        jac_[c] = x.derivative();
     }
     int numCols() const
     {
-        return v.size();
+        return values_.cols();
+    }
+    int size() const
+    {
+        return values_.rows();
+    }
+    const Values& values() const
+    {
+        return values_;
+    }
+    bool hasDerivatives() const
+    {
+        for (const Jacobian& jac : jac_) {
+            if (!jac.empty()) {
+                return true;
+            }
+        }
+        return false;
     }
 private:
-    std::vector<CollOfScalar> v;
+    Values values_;
+    std::vector<Jacobian> jac_;
 };
 
 inline CollOfVector operator+(const CollOfVector& v1, const CollOfVector& v2)
 {
+    assert(v1.numCols() == v2.numCols());
+    if (!v1.hasDerivatives() && !v2.hasDerivatives()) {
+        return CollOfVector(v1.values() + v2.values());
+    }
     const int dim = v1.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(v1.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = v1.col(d) + v2.col(d);
+        res.setCol(d, v1.col(d) + v2.col(d));
     }
     return res;
 }
 
 inline CollOfVector operator-(const CollOfVector& v1, const CollOfVector& v2)
 {
+    assert(v1.numCols() == v2.numCols());
+    if (!v1.hasDerivatives() && !v2.hasDerivatives()) {
+        return CollOfVector(v1.values() - v2.values());
+    }
     const int dim = v1.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(v1.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = v1.col(d) - v2.col(d);
+        res.setCol(d, v1.col(d) - v2.col(d));
     }
     return res;
 }
 
 inline CollOfVector operator-(const CollOfVector& x)
 {
+    if (!x.hasDerivatives()) {
+        return CollOfVector(-x.values());
+    }
     const int dim = x.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(x.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = -x.col(d);
+        res.setCol(d, -x.col(d));
     }
     return res;
 }
 
 inline CollOfVector operator*(const CollOfVector& x, const Scalar& s)
 {
+    if (!x.hasDerivatives()) {
+        return CollOfVector(x.values() * s);
+    }
     const int dim = x.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(x.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = x.col(d) * s;
+        res.setCol(d, x.col(d) * s);
     }
     return res;
 }
 
 inline CollOfVector operator*(const CollOfVector& x, const CollOfScalar& s)
 {
+    if (!x.hasDerivatives() && s.derivative().empty()) {
+        return CollOfVector(x.values().colwise() * s.value());
+    }
     const int dim = x.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(x.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = x.col(d) * s;
+        res.setCol(d, x.col(d) * s);
     }
     return res;
 }
@@ -297,78 +741,51 @@ inline CollOfVector operator*(const CollOfScalar& s, const CollOfVector& x)
 
 inline CollOfVector operator/(const CollOfVector& x, const Scalar& s)
 {
+    if (!x.hasDerivatives()) {
+        return CollOfVector(x.values() / s);
+    }
     const int dim = x.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(x.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = x.col(d) / s;
+        res.setCol(d, x.col(d) / s);
     }
     return res;
 }
 
 inline CollOfVector operator/(const CollOfVector& x, const CollOfScalar& s)
 {
+    if (!x.hasDerivatives() && s.derivative().empty()) {
+        return CollOfVector(x.values().colwise() / s.value());
+    }
     const int dim = x.numCols();
-    CollOfVector res(dim);
+    CollOfVector res(x.size(), dim);
     for (int d = 0; d < dim; ++d) {
-        res.col(d) = x.col(d) / s;
+        res.setCol(d, x.col(d) / s);
     }
     return res;
 }
 
 
 /// A helper type for ensuring AutoDiffBlock objects are converted
-/// to CollOfScalar when necessary for template functions.
-template <class Coll>
+/// to CollOfScalar, and Eigen array expressions to CollOfScalarValue
+/// or CollOfBool, when necessary for template functions.
+template <class Coll, class Enable = void>
 struct CollType { typedef Coll Type; };
 template<>
 struct CollType<Opm::AutoDiffBlock<double>> { typedef CollOfScalar Type; };
+template <class Expr>
+struct CollType<Expr, typename std::enable_if<std::is_base_of<Eigen::ArrayBase<Expr>, Expr>::value>::type>
+{
+    typedef typename std::conditional<std::is_same<typename Expr::Scalar, bool>::value,
+                                      CollOfBool, CollOfScalarValue>::type Type;
+};
 
 
 /// Simplify support of array literals.
-// template <typename T>
-// std::array<typename CollType<T>::Type, 1> makeArray(const T& t)
-// {
-//     return std::array<typename CollType<T>::Type,1>{{t}};
-// }
-template <typename T>
-std::tuple<typename CollType<T>::Type> makeArray(const T& t)
-{
-    return std::tuple<typename CollType<T>::Type>{t};
-}
-// template <typename T1, typename T2>
-// std::array<typename CollType<T1>::Type, 2> makeArray(const T1& t1, const T2& t2)
-// {
-//     return std::array<typename CollType<T1>::Type,2>{{t1, t2}};
-// }
-template <typename T1, typename T2>
-std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type> makeArray(const T1& t1, const T2& t2)
-{
-    return std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type>{t1, t2};
-}
-// template <typename T1, typename T2, typename T3>
-// std::array<typename CollType<T1>::Type, 3> makeArray(const T1& t1, const T2& t2, const T3& t3)
-// {
-//     return std::array<typename CollType<T1>::Type,3>{{t1, t2, t3}};
-// }
-template <typename T1, typename T2, typename T3>
-std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type, typename CollType<T3>::Type>
-makeArray(const T1& t1, const T2& t2, const T3& t3)
-{
-    return std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type, typename CollType<T3>::Type>
-        {t1, t2, t3};
-}
-// template <typename T1, typename T2, typename T3, typename T4>
-// std::array<typename CollType<T1>::Type, 4> makeArray(const T1& t1, const T2& t2, const T3& t3, const T4& t4)
-// {
-//     return std::array<typename CollType<T1>::Type,4>{{t1, t2, t3, t4}};
-// }
-template <typename T1, typename T2, typename T3, typename T4>
-std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type, typename CollType<T3>::Type, typename CollType<T4>::Type>
-makeArray(const T1& t1, const T2& t2, const T3& t3, const T4& t4)
-{
-    return std::tuple<typename CollType<T1>::Type, typename CollType<T2>::Type, typename CollType<T3>::Type, typename CollType<T4>::Type>
-
-        {t1, t2, t3, t4};
+template <typename ... Ts>
+std::tuple<typename CollType<Ts>::Type...> makeArray(const Ts& ... ts)
+{
+    return std::tuple<typename CollType<Ts>::Type...>{ts...};
 }
 
 /// A helper type for newtonSolveSystem
@@ -0,0 +1,274 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/AutoDiffKernels.hpp"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+
+namespace equelle {
+
+
+/// Returns S m for the stencil S, column by column, without forming S.
+CollOfScalar::M stencilRows(const CollOfScalar::M& m, const RowStencil& st)
+{
+    SparseColMajor s;
+    m.toSparse(s);
+    s.makeCompressed();
+    assert(s.rows() + 1 == int(st.start.size()));
+    const int cols = s.cols();
+    const int* outer = s.outerIndexPtr();
+    const int* inner = s.innerIndexPtr();
+    const double* val = s.valuePtr();
+
+    // Column c is first computed in positions bound[c] to bound[c + 1],
+    // room for all its products before repeated rows are merged.
+    std::vector<int> bound(cols + 1, 0);
+    for (int c = 0; c < cols; ++c) {
+        int size = 0;
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            size += st.start[inner[k] + 1] - st.start[inner[k]];
+        }
+        bound[c + 1] = bound[c] + size;
+    }
+    std::vector<int> t_inner(bound[cols]);
+    std::vector<double> t_val(bound[cols]);
+    std::vector<int> count(cols);
+#pragma omp parallel for
+    for (int c = 0; c < cols; ++c) {
+        int* ci = &t_inner[0] + bound[c];
+        double* cv = &t_val[0] + bound[c];
+        int n = 0;
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            const int r = inner[k];
+            for (int j = st.start[r]; j < st.start[r + 1]; ++j) {
+                // Insertion sort by row. It is stable, so repeated rows
+                // are summed in the order of m. The columns are short.
+                const int row = st.target[j];
+                const double v = st.weight[j] * val[k];
+                int pos = n++;
+                while (pos > 0 && ci[pos - 1] > row) {
+                    ci[pos] = ci[pos - 1];
+                    cv[pos] = cv[pos - 1];
+                    --pos;
+                }
+                ci[pos] = row;
+                cv[pos] = v;
+            }
+        }
+        int last = -1;
+        for (int k = 0; k < n; ++k) {
+            if (last >= 0 && ci[last] == ci[k]) {
+                cv[last] += cv[k];
+            } else {
+                ++last;
+                ci[last] = ci[k];
+                cv[last] = cv[k];
+            }
+        }
+        count[c] = last + 1;
+    }
+
+    SparseColMajor r(st.rows, cols);
+    int* r_outer = r.outerIndexPtr();
+    r_outer[0] = 0;
+    for (int c = 0; c < cols; ++c) {
+        r_outer[c + 1] = r_outer[c] + count[c];
+    }
+    r.resizeNonZeros(r_outer[cols]);
+    int* r_inner = r.innerIndexPtr();
+    double* r_val = r.valuePtr();
+#pragma omp parallel for
+    for (int c = 0; c < cols; ++c) {
+        std::copy(&t_inner[0] + bound[c], &t_inner[0] + bound[c] + count[c], r_inner + r_outer[c]);
+        std::copy(&t_val[0] + bound[c], &t_val[0] + bound[c] + count[c], r_val + r_outer[c]);
+    }
+    return CollOfScalar::M(std::move(r));
+}
+
+
+/// Returns S x for the stencil S, with jacobians.
+CollOfScalar applyStencil(const CollOfScalar::ADB& x, const RowStencil& st)
+{
+    const CollOfScalar::V& xv = x.value();
+    const int n = xv.size();
+    assert(n + 1 == int(st.start.size()));
+    CollOfScalar::V val = CollOfScalar::V::Zero(st.rows);
+    for (int r = 0; r < n; ++r) {
+        for (int k = st.start[r]; k < st.start[r + 1]; ++k) {
+            val[st.target[k]] += st.weight[k] * xv[r];
+        }
+    }
+    const auto& xjac = x.derivative();
+    if (xjac.empty()) {
+        return CollOfScalar(val);
+    }
+    const int num_blocks = xjac.size();
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        jac[block] = stencilRows(xjac[block], st);
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+
+/// Returns diag(d) m, row i of m scaled by d[i], with the pattern of m.
+CollOfScalar::M scaleRows(const CollOfScalar::V& d, const CollOfScalar::M& m)
+{
+    SparseColMajor s;
+    m.toSparse(s);
+    s.makeCompressed();
+    assert(s.rows() == d.size());
+    const int cols = s.cols();
+    const int* outer = s.outerIndexPtr();
+    const int* inner = s.innerIndexPtr();
+    double* val = s.valuePtr();
+#pragma omp parallel for
+    for (int c = 0; c < cols; ++c) {
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            val[k] *= d[inner[k]];
+        }
+    }
+    return CollOfScalar::M(std::move(s));
+}
+
+
+/// Returns diag(a) ma + diag(b) mb, with the union of the patterns of ma
+/// and mb. Entries in both are summed in that order, as in the sum of
+/// the two products.
+CollOfScalar::M scaleRowsSum(const CollOfScalar::V& a, const CollOfScalar::M& ma,
+                             const CollOfScalar::V& b, const CollOfScalar::M& mb)
+{
+    SparseColMajor sa;
+    SparseColMajor sb;
+    ma.toSparse(sa);
+    mb.toSparse(sb);
+    sa.makeCompressed();
+    sb.makeCompressed();
+    const int rows = sa.rows();
+    const int cols = sa.cols();
+    assert(sb.rows() == rows && sb.cols() == cols && a.size() == rows && b.size() == rows);
+    const int* a_outer = sa.outerIndexPtr();
+    const int* a_inner = sa.innerIndexPtr();
+    const double* a_val = sa.valuePtr();
+    const int* b_outer = sb.outerIndexPtr();
+    const int* b_inner = sb.innerIndexPtr();
+    const double* b_val = sb.valuePtr();
+
+    // Count the rows of the union of each column, both sides are sorted
+    // by row.
+    std::vector<int> count(cols);
+#pragma omp parallel for
+    for (int c = 0; c < cols; ++c) {
+        int n = 0;
+        int ka = a_outer[c];
+        int kb = b_outer[c];
+        while (ka < a_outer[c + 1] || kb < b_outer[c + 1]) {
+            const int row_a = ka < a_outer[c + 1] ? a_inner[ka] : rows;
+            const int row_b = kb < b_outer[c + 1] ? b_inner[kb] : rows;
+            const int row = std::min(row_a, row_b);
+            ka += (row_a == row);
+            kb += (row_b == row);
+            ++n;
+        }
+        count[c] = n;
+    }
+    SparseColMajor r(rows, cols);
+    int* r_outer = r.outerIndexPtr();
+    r_outer[0] = 0;
+    for (int c = 0; c < cols; ++c) {
+        r_outer[c + 1] = r_outer[c] + count[c];
+    }
+    r.resizeNonZeros(r_outer[cols]);
+
+    // Merge the scaled entries.
+    int* r_inner = r.innerIndexPtr();
+    double* r_val = r.valuePtr();
+#pragma omp parallel for
+    for (int c = 0; c < cols; ++c) {
+        int pos = r_outer[c];
+        int ka = a_outer[c];
+        int kb = b_outer[c];
+        while (ka < a_outer[c + 1] || kb < b_outer[c + 1]) {
+            const int row_a = ka < a_outer[c + 1] ? a_inner[ka] : rows;
+            const int row_b = kb < b_outer[c + 1] ? b_inner[kb] : rows;
+            const int row = std::min(row_a, row_b);
+            r_inner[pos] = row;
+            if (row_a == row && row_b == row) {
+                r_val[pos] = a[row] * a_val[ka] + b[row] * b_val[kb];
+            } else if (row_a == row) {
+                r_val[pos] = a[row] * a_val[ka];
+            } else {
+                r_val[pos] = b[row] * b_val[kb];
+            }
+            ++pos;
+            ka += (row_a == row);
+            kb += (row_b == row);
+        }
+    }
+    return CollOfScalar::M(std::move(r));
+}
+
+
+CollOfScalar multiply(const CollOfScalar::ADB& x, const CollOfScalar::ADB& y)
+{
+    const CollOfScalar::V& xv = x.value();
+    const CollOfScalar::V& yv = y.value();
+    assert(xv.size() == yv.size());
+    CollOfScalar::V val = xv * yv;
+    const auto& xjac = x.derivative();
+    const auto& yjac = y.derivative();
+    if (xjac.empty() && yjac.empty()) {
+        return CollOfScalar(val);
+    }
+    // The derivative is diag(y) dx + diag(x) dy.
+    const int num_blocks = std::max(xjac.size(), yjac.size());
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        if (yjac.empty()) {
+            jac[block] = scaleRows(yv, xjac[block]);
+        } else if (xjac.empty()) {
+            jac[block] = scaleRows(xv, yjac[block]);
+        } else {
+            jac[block] = scaleRowsSum(yv, xjac[block], xv, yjac[block]);
+        }
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+
+CollOfScalar divide(const CollOfScalar::ADB& x, const CollOfScalar::ADB& y)
+{
+    const CollOfScalar::V& xv = x.value();
+    const CollOfScalar::V& yv = y.value();
+    assert(xv.size() == yv.size());
+    CollOfScalar::V val = xv / yv;
+    const auto& xjac = x.derivative();
+    const auto& yjac = y.derivative();
+    if (xjac.empty() && yjac.empty()) {
+        return CollOfScalar(val);
+    }
+    // The derivative is diag(y / y^2) dx - diag(x / y^2) dy.
+    const CollOfScalar::V inv_y_squared = 1.0 / (yv * yv);
+    const CollOfScalar::V dx_scale = yv * inv_y_squared;
+    const CollOfScalar::V dy_scale = -(xv * inv_y_squared);
+    const int num_blocks = std::max(xjac.size(), yjac.size());
+    std::vector<CollOfScalar::M> jac(num_blocks);
+    for (int block = 0; block < num_blocks; ++block) {
+        if (yjac.empty()) {
+            jac[block] = scaleRows(dx_scale, xjac[block]);
+        } else if (xjac.empty()) {
+            jac[block] = scaleRows(dy_scale, yjac[block]);
+        } else {
+            jac[block] = scaleRowsSum(dx_scale, xjac[block], dy_scale, yjac[block]);
+        }
+    }
+    return CollOfScalar::ADB::function(std::move(val), std::move(jac));
+}
+
+
+} // namespace equelle
@@ -0,0 +1,200 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/BlockCsrMatrix.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace equelle {
+
+
+BlockCsrMatrix::BlockCsrMatrix()
+    : block_size_(1),
+      block_rows_(0),
+      row_start_(1, 0)
+{
+}
+
+
+void BlockCsrMatrix::setPattern(const SparseColMajor& m, const int block_size)
+{
+    if (block_size < 1 || m.rows() != m.cols() || m.rows() % block_size != 0) {
+        OPM_THROW(std::runtime_error, "Cannot make blocks of size " << block_size
+                  << " for a " << m.rows() << " x " << m.cols() << " matrix.");
+    }
+    block_size_ = block_size;
+    block_rows_ = m.rows() / block_size;
+    const int n = block_rows_;
+    const int bs = block_size_;
+    const int cols = m.cols();
+    const int* outer = m.outerIndexPtr();
+    const int* inner = m.innerIndexPtr();
+
+    // Block columns of each block row, including the diagonal.
+    std::vector<std::vector<int> > row_cols(n);
+    for (int e = 0; e < n; ++e) {
+        row_cols[e].push_back(e);
+    }
+    for (int c = 0; c < cols; ++c) {
+        const int f = c % n;
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            row_cols[inner[k] % n].push_back(f);
+        }
+    }
+    row_start_.assign(n + 1, 0);
+    for (int e = 0; e < n; ++e) {
+        std::vector<int>& rc = row_cols[e];
+        std::sort(rc.begin(), rc.end());
+        rc.erase(std::unique(rc.begin(), rc.end()), rc.end());
+        row_start_[e + 1] = row_start_[e] + rc.size();
+    }
+    col_index_.resize(row_start_[n]);
+    diagonal_.resize(n);
+    for (int e = 0; e < n; ++e) {
+        std::copy(row_cols[e].begin(), row_cols[e].end(), col_index_.begin() + row_start_[e]);
+        diagonal_[e] = std::lower_bound(col_index_.begin() + row_start_[e],
+                                        col_index_.begin() + row_start_[e + 1], e) - col_index_.begin();
+    }
+
+    // Positions of the entries in the block values.
+    value_position_.resize(m.nonZeros());
+    for (int c = 0; c < cols; ++c) {
+        const int f = c % n;
+        const int j = c / n;
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            const int e = inner[k] % n;
+            const int i = inner[k] / n;
+            const int block = std::lower_bound(col_index_.begin() + row_start_[e],
+                                               col_index_.begin() + row_start_[e + 1], f) - col_index_.begin();
+            value_position_[k] = block*bs*bs + i*bs + j;
+        }
+    }
+    values_.assign(row_start_[n]*bs*bs, 0.0);
+    setValues(m);
+}
+
+
+void BlockCsrMatrix::setValues(const SparseColMajor& m)
+{
+    const int nnz = m.nonZeros();
+    const double* val = m.valuePtr();
+    // Entries missing from m (in particular in the padded diagonal
+    // blocks) are zero, and stay zero since the pattern is unchanged.
+#pragma omp parallel for
+    for (int k = 0; k < nnz; ++k) {
+        values_[value_position_[k]] = val[k];
+    }
+}
+
+
+void BlockCsrMatrix::setBlocks(const int block_size,
+                               std::vector<int>& row_start,
+                               std::vector<int>& col_index,
+                               std::vector<double>& values)
+{
+    block_size_ = block_size;
+    block_rows_ = row_start.size() - 1;
+    row_start_.swap(row_start);
+    col_index_.swap(col_index);
+    values_.swap(values);
+    value_position_.clear();
+    const int n = block_rows_;
+    diagonal_.resize(n);
+    for (int e = 0; e < n; ++e) {
+        const std::vector<int>::iterator end = col_index_.begin() + row_start_[e + 1];
+        const std::vector<int>::iterator d = std::lower_bound(col_index_.begin() + row_start_[e], end, e);
+        if (d == end || *d != e) {
+            OPM_THROW(std::runtime_error, "Missing diagonal block in block row " << e << ".");
+        }
+        diagonal_[e] = d - col_index_.begin();
+    }
+}
+
+
+int BlockCsrMatrix::blockSize() const
+{
+    return block_size_;
+}
+
+
+int BlockCsrMatrix::blockRows() const
+{
+    return block_rows_;
+}
+
+
+const std::vector<int>& BlockCsrMatrix::rowStart() const
+{
+    return row_start_;
+}
+
+
+const std::vector<int>& BlockCsrMatrix::colIndex() const
+{
+    return col_index_;
+}
+
+
+const std::vector<int>& BlockCsrMatrix::diagonal() const
+{
+    return diagonal_;
+}
+
+
+const std::vector<double>& BlockCsrMatrix::values() const
+{
+    return values_;
+}
+
+
+void BlockCsrMatrix::multiply(const double* x, double* y) const
+{
+    const int bs = block_size_;
+#pragma omp parallel for
+    for (int e = 0; e < block_rows_; ++e) {
+        double* ye = y + e*bs;
+        std::fill(ye, ye + bs, 0.0);
+        for (int b = row_start_[e]; b < row_start_[e + 1]; ++b) {
+            const double* a = &values_[b*bs*bs];
+            const double* xf = x + col_index_[b]*bs;
+            for (int i = 0; i < bs; ++i) {
+                for (int j = 0; j < bs; ++j) {
+                    ye[i] += a[i*bs + j] * xf[j];
+                }
+            }
+        }
+    }
+}
+
+
+void BlockCsrMatrix::toBlockOrder(const double* x, double* z) const
+{
+    const int n = block_rows_;
+    const int bs = block_size_;
+#pragma omp parallel for
+    for (int e = 0; e < n; ++e) {
+        for (int j = 0; j < bs; ++j) {
+            z[e*bs + j] = x[j*n + e];
+        }
+    }
+}
+
+
+void BlockCsrMatrix::fromBlockOrder(const double* z, double* x) const
+{
+    const int n = block_rows_;
+    const int bs = block_size_;
+#pragma omp parallel for
+    for (int e = 0; e < n; ++e) {
+        for (int j = 0; j < bs; ++j) {
+            x[j*n + e] = z[e*bs + j];
+        }
+    }
+}
+
+
+} // namespace equelle
@@ -14,6 +14,7 @@
 
 #include "equelle/CartesianGrid.hpp"
 #include "equelle/equelleTypes.hpp"
+#include "equelle/FieldFile.hpp"
 
 equelle::CartesianGrid::CartesianGrid()
 {
@@ -41,6 +42,19 @@ equelle::StencilCollOfScalar equelle::CartesianEquelleRuntime::inputCellCollecti
     const bool from_file = param_.getDefault(name + "_from_file", false);
     if ( from_file ) {
         const String filename = param_.get<String>(name + "_filename");
+        if ( isBinaryInput(param_.getDefault<String>(name + "_format", "auto"), filename) ) {
+            const FieldFile file(filename);
+            if ( file.size() != std::get<0>(dims) * std::get<1>(dims) || file.entity() == FieldEntity::Faces ) {
+                OPM_THROW(std::runtime_error, "Unexpected size of input data for " << name << " in file " << filename);
+            }
+            int k = 0;
+            for( int j = 0; j < std::get<1>(dims); ++j ) {
+                for( int i = 0; i < std::get<0>(dims); ++i ) {
+                    v.grid.cellAt( v, i, j ) = file.value(k++);
+                }
+            }
+            return v;
+        }
         std::ifstream is(filename.c_str());
         if (!is) {
             OPM_THROW(std::runtime_error, "Could not find file " << filename);
@@ -10,13 +10,152 @@
 #include <fstream>
 #include <iterator>
 #include <stdexcept>
+#include <numeric>
 #include <set>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 
 
 namespace equelle {
 
+namespace
+{
+    /// Returns true if the sorted collection subset is contained in superset.
+    template <class EntityCollection>
+    bool isSubsetOf(const EntityCollection& subset, const EntityCollection& superset)
+    {
+        if (superset.isFull()) {
+            // No need to traverse the superset, just check the index range.
+            return subset.empty()
+                || (subset[0].index >= 0 && subset[subset.size() - 1].index < int(superset.size()));
+        }
+        return std::includes(superset.begin(), superset.end(), subset.begin(), subset.end());
+    }
+
+    /// The cells on the given side (0 for first, 1 for second) of each face.
+    CollOfCell faceCells(const UnstructuredGrid& grid, const CollOfFace& faces, const int side)
+    {
+        const int n = faces.size();
+        std::vector<Cell> fcells(n);
+        for (int i = 0; i < n; ++i) {
+            fcells[i].index = grid.face_cells[2*faces[i].index + side];
+        }
+        return CollOfCell(std::move(fcells));
+    }
+
+    /// Copies an array of dim-dimensional points or vectors, stored
+    /// contiguously per entity, into separate columns.
+    CollOfVector::Values toColumns(const double* data, const int n, const int dim)
+    {
+        CollOfVector::Values cols(n, dim);
+        for (int i = 0; i < n; ++i) {
+            for (int d = 0; d < dim; ++d) {
+                cols(i, d) = data[dim*i + d];
+            }
+        }
+        return cols;
+    }
+
+    /// The rows of the geometry columns for the given entities.
+    template <class EntityCollection>
+    CollOfVector geometryOf(const CollOfVector::Values& columns,
+                            const EntityCollection& entities)
+    {
+        if (entities.isFull()) {
+            return CollOfVector(columns);
+        }
+        const int n = entities.size();
+        const int dim = columns.cols();
+        CollOfVector::Values c(n, dim);
+        for (int d = 0; d < dim; ++d) {
+            const double* column = columns.col(d).data();
+            double* result = c.col(d).data();
+            for (int i = 0; i < n; ++i) {
+                result[i] = column[entities[i].index];
+            }
+        }
+        return CollOfVector(std::move(c));
+    }
+
+    /// The elements of the geometry column for the given entities.
+    template <class EntityCollection>
+    CollOfScalar geometryOf(const CollOfScalar::V& column,
+                            const EntityCollection& entities)
+    {
+        if (entities.isFull()) {
+            return column;
+        }
+        const int n = entities.size();
+        CollOfScalar::V c(n);
+        for (int i = 0; i < n; ++i) {
+            c[i] = column[entities[i].index];
+        }
+        return c;
+    }
+
+    /// Stencil from the given faces to their cells, with weight 1 for
+    /// the first and -1 for the second cell, as in a divergence.
+    template <class FaceIndices>
+    RowStencil faceStencil(const UnstructuredGrid& grid, const FaceIndices& faces, const int num_cells)
+    {
+        RowStencil st;
+        st.rows = num_cells;
+        st.start.assign(1, 0);
+        const int n = faces.size();
+        for (int i = 0; i < n; ++i) {
+            const int c1 = grid.face_cells[2*faces[i]];
+            const int c2 = grid.face_cells[2*faces[i] + 1];
+            if (c1 >= 0 && (c2 < 0 || c1 < c2)) {
+                st.target.push_back(c1);
+                st.weight.push_back(1.0);
+            }
+            if (c2 >= 0) {
+                st.target.push_back(c2);
+                st.weight.push_back(-1.0);
+            }
+            if (c1 >= 0 && c2 >= 0 && c1 > c2) {
+                st.target.push_back(c1);
+                st.weight.push_back(1.0);
+            }
+            st.start.push_back(st.target.size());
+        }
+        return st;
+    }
+
+    /// Reads the newton_forcing parameter, true for Eisenstat-Walker forcing.
+    bool useEisenstatWalker(const Opm::ParameterGroup& param)
+    {
+        const std::string forcing = param.getDefault<std::string>("newton_forcing", "constant");
+        if (forcing != "constant" && forcing != "EisenstatWalker") {
+            OPM_THROW(std::runtime_error, "Illegal input " << forcing << " for newton_forcing, use constant or EisenstatWalker.");
+        }
+        return forcing == "EisenstatWalker";
+    }
+
+    /// Sets the number of threads used by the OpenMP loops of the
+    /// runtime and by Eigen from the threads parameter, where 0 means
+    /// one per processor. Returns the number of threads, always 1 when
+    /// built without OpenMP.
+    int setupThreads(const Opm::ParameterGroup& param)
+    {
+        const int threads = param.getDefault("threads", 1);
+        if (threads < 0) {
+            OPM_THROW(std::runtime_error, "Illegal input " << threads << " for threads, use 0 or more.");
+        }
+#ifdef _OPENMP
+        const int num = threads == 0 ? omp_get_num_procs() : threads;
+        omp_set_num_threads(num);
+        Eigen::setNbThreads(num);
+        return num;
+#else
+        return 1;
+#endif
+    }
+} // anon namespace
+
 Opm::GridManager* createGridManager(const Opm::ParameterGroup& param)
 {
     if (param.has("grid_filename")) {
@@ -55,190 +194,150 @@ EquelleRuntimeCPU::EquelleRuntimeCPU(const Opm::ParameterGroup& param)
     : grid_manager_(equelle::createGridManager(param)),
       grid_(*(grid_manager_->c_grid())),
       ops_(grid_),
-      linsolver_(param),
+      linsolver_(0),
+      telemetry_filename_(param.getDefault<std::string>("telemetry_filename", "")),
       output_to_file_(param.getDefault("output_to_file", false)),
       verbose_(param.getDefault("verbose", 0)),
+      threads_(setupThreads(param)),
       param_(param),
+      output_writer_(param, grid_),
       max_iter_(param.getDefault("max_iter", 10)),
-      abs_res_tol_(param.getDefault("abs_res_tol", 1e-6))
-{
+      abs_res_tol_(param.getDefault("abs_res_tol", 1e-6)),
+      rel_res_tol_(param.getDefault("rel_res_tol", 0.0)),
+      update_tol_(param.getDefault("update_tol", 0.0)),
+      eisenstat_walker_(useEisenstatWalker(param)),
+      forcing_max_(param.getDefault("forcing_max", 0.9)),
+      line_search_(param.getDefault("line_search", false)),
+      line_search_max_cuts_(param.getDefault("line_search_max_cuts", 8)),
+      jacobian_free_(param.getDefault("jfnk", false)),
+      subset_index_cache_prune_size_(64),
+      subset_index_cache_hits_(0),
+      subset_index_cache_misses_(0)
+{
+    initTopology();
+    initGeometry();
 }
 
 EquelleRuntimeCPU::EquelleRuntimeCPU(const UnstructuredGrid *grid, const Opm::ParameterGroup &param)
     : grid_( *grid ),
       ops_(grid_),
-      linsolver_(param),
+      linsolver_(0),
+      telemetry_filename_(param.getDefault<std::string>("telemetry_filename", "")),
       output_to_file_(param.getDefault("output_to_file", false)),
       verbose_(param.getDefault("verbose", 0)),
+      threads_(setupThreads(param)),
       param_(param),
+      output_writer_(param, grid_),
       max_iter_(param.getDefault("max_iter", 10)),
-      abs_res_tol_(param.getDefault("abs_res_tol", 1e-6))
-{
-
-}
-
-CollOfCell EquelleRuntimeCPU::allCells() const
-{
-    const int nc = grid_.number_of_cells;
-    CollOfCell cells(nc);
-    for (int c = 0; c < nc; ++c) {
-        cells[c].index = c;
+      abs_res_tol_(param.getDefault("abs_res_tol", 1e-6)),
+      rel_res_tol_(param.getDefault("rel_res_tol", 0.0)),
+      update_tol_(param.getDefault("update_tol", 0.0)),
+      eisenstat_walker_(useEisenstatWalker(param)),
+      forcing_max_(param.getDefault("forcing_max", 0.9)),
+      line_search_(param.getDefault("line_search", false)),
+      line_search_max_cuts_(param.getDefault("line_search_max_cuts", 8)),
+      jacobian_free_(param.getDefault("jfnk", false)),
+      subset_index_cache_prune_size_(64),
+      subset_index_cache_hits_(0),
+      subset_index_cache_misses_(0)
+{
+    initTopology();
+    initGeometry();
+}
+
+EquelleRuntimeCPU::~EquelleRuntimeCPU()
+{
+    try {
+        output_writer_.flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to write output: " << e.what() << std::endl;
+    }
+    writeTelemetry();
+    if (verbose_ > 0) {
+        std::cout << "Threads: " << threads_ << std::endl;
+        std::cout << "Subset index cache: " << subset_index_cache_hits_ << " hits, "
+                  << subset_index_cache_misses_ << " misses." << std::endl;
+        for (auto it = linsolvers_.begin(); it != linsolvers_.end(); ++it) {
+            const LinearSolver& ls = *it->second;
+            std::cout << "Newton site " << it->first << ": linear system pattern "
+                      << ls.patternReuses() << " reused, " << ls.patternRebuilds() << " rebuilt; preconditioner "
+                      << ls.preconditionerReuses() << " reused, " << ls.preconditionerSetups() << " set up." << std::endl;
+        }
     }
-    return cells;
 }
 
-
-// Note that this will not produce what some would consider the expected results for a 1D grid realized as a 2D grid of dimension (n, 1) or (1, n), since all cells
-// of such a grid are boundary cells.
-// That points out that communicating the grid concepts is very important.
-bool EquelleRuntimeCPU::boundaryCell(const int cell_index) const
+CollOfCell EquelleRuntimeCPU::allCells() const
 {
-    for (int hface = grid_.cell_facepos[cell_index]; hface < grid_.cell_facepos[cell_index + 1]; ++hface) {
-        const int face = grid_.cell_faces[hface];
-        if (grid_.face_cells[2*face] == Boundary::outer || grid_.face_cells[2*face + 1] == Boundary::outer ) {
-            return true;
-        }
-    }
-    return false;
+    return CollOfCell::full(grid_.number_of_cells);
 }
 
 
-CollOfCell EquelleRuntimeCPU::boundaryCells() const
+const CollOfCell& EquelleRuntimeCPU::boundaryCells() const
 {
-    CollOfCell cells;
-    const int nc = grid_.number_of_cells;
-    cells.reserve(nc);
-    for (int c = 0; c < nc; ++c) {
-        if ( boundaryCell(c) ) {
-            cells.emplace_back( Cell(c) );
-        }
-    }
-    return cells;
+    return boundary_cells_;
 }
 
 
-CollOfCell EquelleRuntimeCPU::interiorCells() const
+const CollOfCell& EquelleRuntimeCPU::interiorCells() const
 {
-    CollOfCell cells;
-    const int nc = grid_.number_of_cells;
-    cells.reserve(nc);
-    for (int c = 0; c < nc; ++c) {
-        if ( !boundaryCell(c) ) {
-            cells.emplace_back( Cell(c) );
-        }
-    }
-    return cells;
+    return interior_cells_;
 }
 
 
 CollOfFace EquelleRuntimeCPU::allFaces() const
 {
-    const int nf = grid_.number_of_faces;
-    CollOfFace faces(nf);
-    for (int f = 0; f < nf; ++f) {
-        faces[f].index = f;
-    }
-    return faces;
+    return CollOfFace::full(grid_.number_of_faces);
 }
 
 
-// Again... this is kind of botched for a 1D grid implemented as a 2D(n, 1) or 2D(1, n) grid...
-
-CollOfFace EquelleRuntimeCPU::boundaryFaces() const
+const CollOfFace& EquelleRuntimeCPU::boundaryFaces() const
 {
-    const int nif = ops_.internal_faces.size();
-    const int nbf = grid_.number_of_faces - nif;
-    CollOfFace bfaces(nbf);
-    int if_cursor = 0;
-    int bf_cursor = 0;
-
-    // This works as long as ops_.internal_faces(i)<ops_.internal_faces(i+1), which it currently is.
-    // Would be better to extend HelperOps to support this functionality.
-
-    for (int i = 0; i < grid_.number_of_faces; ++i) {
-        // Advance if_cursor so that the next internal face to look out for has larger or equal index to i
-        while ( (if_cursor < nif) && (i > ops_.internal_faces[if_cursor]) ) {
-            ++if_cursor;
-        }
-        // Now if_cursor points beyond the last internal face, or internal_face[if_cursor]>=i.
-        // If (if_cursor points beyond the last internal face) or (internal_face[if_cursor] is truly > i), we surely have a boundary face...
-        if ( (if_cursor == nif) || (ops_.internal_faces[if_cursor] > i) ) {
-            bfaces[bf_cursor].index = i;
-            ++bf_cursor;
-        }
-    }
-
-    return bfaces;
+    return boundary_faces_;
 }
 
 
-CollOfFace EquelleRuntimeCPU::interiorFaces() const
+const CollOfFace& EquelleRuntimeCPU::interiorFaces() const
 {
-    const int nif = ops_.internal_faces.size();
-    CollOfFace ifaces(nif);
-    for (int i = 0; i < nif; ++i) {
-        ifaces[i].index = ops_.internal_faces(i);
-    }
-    return ifaces;
+    return interior_faces_;
 }
 
 
 CollOfCell EquelleRuntimeCPU::firstCell(const CollOfFace& faces) const
 {
-    const int n = faces.size();
-    CollOfCell fcells(n);
-    for (int i = 0; i < n; ++i) {
-        fcells[i].index = grid_.face_cells[2*faces[i].index];
-    }
-    return fcells;
+    const CollOfCell* precomputed = precomputedFaceCells(faces, 0);
+    return precomputed ? *precomputed : faceCells(grid_, faces, 0);
 }
 
 
 CollOfCell EquelleRuntimeCPU::secondCell(const CollOfFace& faces) const
 {
-    const int n = faces.size();
-    CollOfCell fcells(n);
-    for (int i = 0; i < n; ++i) {
-        fcells[i].index = grid_.face_cells[2*faces[i].index + 1];
-    }
-    return fcells;
+    const CollOfCell* precomputed = precomputedFaceCells(faces, 1);
+    return precomputed ? *precomputed : faceCells(grid_, faces, 1);
 }
 
 
 CollOfScalar EquelleRuntimeCPU::norm(const CollOfFace& faces) const
 {
-    const int n = faces.size();
-    CollOfScalar::V areas(n);
-    for (int i = 0; i < n; ++i) {
-        areas[i] = grid_.face_areas[faces[i].index];
-    }
-    return areas;
+    return geometryOf(face_areas_, faces);
 }
 
 
 CollOfScalar EquelleRuntimeCPU::norm(const CollOfCell& cells) const
 {
-    const int n = cells.size();
-    CollOfScalar::V volumes(n);
-    for (int i = 0; i < n; ++i) {
-        volumes[i] = grid_.cell_volumes[cells[i].index];
-    }
-    return volumes;
+    return geometryOf(cell_volumes_, cells);
 }
 
 
 CollOfScalar EquelleRuntimeCPU::norm(const CollOfVector& vectors) const
 {
-    CollOfScalar norm2 = vectors.col(0) * vectors.col(0);
-    const int dim = vectors.numCols();
-    for (int d = 1; d < dim; ++d) {
-        norm2 += vectors.col(d) * vectors.col(d);
+    if (!vectors.hasDerivatives()) {
+        return CollOfScalar::V(vectors.values().square().rowwise().sum().sqrt());
     }
-    return sqrt(norm2);
+    return sqrt(dot(vectors, vectors));
 }
 
 
-CollOfScalar EquelleRuntimeCPU::norm(const CollOfScalar& scalars) const
+CollOfScalar EquelleRuntimeCPU::norm(const CollOfScalar::ADB& scalars) const
 {
     const CollOfScalar::V& v = scalars.value();
     const int sz = v.size();
@@ -254,80 +353,52 @@ CollOfScalar EquelleRuntimeCPU::norm(const CollOfScalar& scalars) const
 }
 
 
+CollOfScalarValue EquelleRuntimeCPU::norm(const CollOfScalarValue& scalars) const
+{
+    return scalars.abs();
+}
+
+
 CollOfVector EquelleRuntimeCPU::centroid(const CollOfFace& faces) const
 {
-    const int n = faces.size();
-    const int dim = grid_.dimensions;
-    Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> c(n, dim);
-    for (int i = 0; i < n; ++i) {
-        const double* fc = grid_.face_centroids + dim * faces[i].index;
-        for (int d = 0; d < dim; ++d) {
-            c(i, d) = fc[d];
-        }
-    }
-    CollOfVector centroids(dim);
-    for (int d = 0; d < dim; ++d) {
-        centroids.col(d) = CollOfScalar(c.col(d));
-    }
-    return centroids;
+    return geometryOf(face_centroids_, faces);
 }
 
 
 CollOfVector EquelleRuntimeCPU::centroid(const CollOfCell& cells) const
 {
-    const int n = cells.size();
-    const int dim = grid_.dimensions;
-    Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> c(n, dim);
-    for (int i = 0; i < n; ++i) {
-        const double* fc = grid_.cell_centroids + dim * cells[i].index;
-        for (int d = 0; d < dim; ++d) {
-            c(i, d) = fc[d];
-        }
-    }
-    CollOfVector centroids(dim);
-    for (int d = 0; d < dim; ++d) {
-        centroids.col(d) = CollOfScalar(c.col(d));
-    }
-    return centroids;
+    return geometryOf(cell_centroids_, cells);
 }
 
 
 CollOfVector EquelleRuntimeCPU::normal(const CollOfFace& faces) const
 {
-    const int n = faces.size();
-    const int dim = grid_.dimensions;
-    Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> nor(n, dim);
-    for (int i = 0; i < n; ++i) {
-        const double* fn = grid_.face_normals + dim * faces[i].index;
-        for (int d = 0; d < dim; ++d) {
-            nor(i, d) = fn[d];
-        }
-    }
-    // Since the UnstructuredGrid uses the unorthodox convention that face
-    // normals are scaled with the face areas, we must renormalize them.
-    nor.colwise() /= nor.matrix().rowwise().norm().array();
-    CollOfVector normals(dim);
-    for (int d = 0; d < dim; ++d) {
-        normals.col(d) = CollOfScalar(nor.col(d));
-    }
-    return normals;
+    return geometryOf(face_unit_normals_, faces);
 }
 
 
-CollOfScalar EquelleRuntimeCPU::sqrt(const CollOfScalar& x) const
+CollOfScalar EquelleRuntimeCPU::sqrt(const CollOfScalar::ADB& x) const
 {
     return equelle::sqrt(x);
 }
 
+CollOfScalarValue EquelleRuntimeCPU::sqrt(const CollOfScalarValue& x) const
+{
+    return x.sqrt();
+}
+
 CollOfScalar EquelleRuntimeCPU::dot(const CollOfVector& v1, const CollOfVector& v2) const
 {
     if (v1.numCols() != v2.numCols()) {
         OPM_THROW(std::logic_error, "Non-matching dimension of Vectors for dot().");
     }
-    if (v1.col(0).size() != v2.col(0).size()) {
+    if (v1.size() != v2.size()) {
         OPM_THROW(std::logic_error, "Non-matching size of Vector collections for dot().");
     }
-    const int dim = grid_.dimensions;
+    if (!v1.hasDerivatives() && !v2.hasDerivatives()) {
+        return CollOfScalar::V((v1.values() * v2.values()).rowwise().sum());
+    }
+    const int dim = v1.numCols();
     CollOfScalar result = v1.col(0) * v2.col(0);
     for (int d = 1; d < dim; ++d) {
         result += v1.col(d) * v2.col(d);
@@ -336,32 +407,100 @@ CollOfScalar EquelleRuntimeCPU::dot(const CollOfVector& v1, const CollOfVector&
 }
 
 
-CollOfScalar EquelleRuntimeCPU::gradient(const CollOfScalar& cell_scalarfield) const
+CollOfScalar EquelleRuntimeCPU::gradient(const CollOfScalar::ADB& cell_scalarfield) const
+{
+    return applyStencil(cell_scalarfield, grad_stencil_);
+}
+
+
+CollOfScalarValue EquelleRuntimeCPU::gradient(const CollOfScalarValue& cell_scalarfield) const
+{
+    // Same as ops_.grad: second minus first cell of each interior face.
+    const int n = ops_.nbi.rows();
+    CollOfScalarValue grad(n);
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i) {
+        grad[i] = cell_scalarfield[ops_.nbi(i, 1)] - cell_scalarfield[ops_.nbi(i, 0)];
+    }
+    return grad;
+}
+
+
+CollOfScalar EquelleRuntimeCPU::negGradient(const CollOfScalar::ADB& cell_scalarfield) const
 {
-    return ops_.grad * cell_scalarfield;//.matrix();
+    return applyStencil(cell_scalarfield, ngrad_stencil_);
 }
 
 
-CollOfScalar EquelleRuntimeCPU::negGradient(const CollOfScalar& cell_scalarfield) const
+CollOfScalarValue EquelleRuntimeCPU::negGradient(const CollOfScalarValue& cell_scalarfield) const
 {
-    return ops_.ngrad * cell_scalarfield;//.matrix();
+    // Same as ops_.ngrad: first minus second cell of each interior face.
+    const int n = ops_.nbi.rows();
+    CollOfScalarValue ngrad(n);
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i) {
+        ngrad[i] = cell_scalarfield[ops_.nbi(i, 0)] - cell_scalarfield[ops_.nbi(i, 1)];
+    }
+    return ngrad;
 }
 
 
-CollOfScalar EquelleRuntimeCPU::divergence(const CollOfScalar& face_fluxes) const
+CollOfScalar EquelleRuntimeCPU::divergence(const CollOfScalar::ADB& face_fluxes) const
 {
     if (face_fluxes.size() == ops_.internal_faces.size()) {
         // This is actually a hack, the compiler should know to emit interiorDivergence()
         // eventually, but as a temporary measure we do this.
         return interiorDivergence(face_fluxes);
     }
-    return ops_.fulldiv * face_fluxes;//.matrix();
+    return applyStencil(face_fluxes, fulldiv_stencil_);
 }
 
 
-CollOfScalar EquelleRuntimeCPU::interiorDivergence(const CollOfScalar& face_fluxes) const
+CollOfScalarValue EquelleRuntimeCPU::divergence(const CollOfScalarValue& face_fluxes) const
 {
-    return ops_.div * face_fluxes;//.matrix();
+    if (face_fluxes.size() == ops_.internal_faces.size()) {
+        // See the comment in the CollOfScalar version.
+        return interiorDivergence(face_fluxes);
+    }
+    // Same as ops_.fulldiv: out of the first cell, into the second.
+    // Gathered per cell from its faces, so the cells are independent.
+    const int nc = grid_.number_of_cells;
+    CollOfScalarValue div(nc);
+#pragma omp parallel for
+    for (int c = 0; c < nc; ++c) {
+        double sum = 0.0;
+        for (int k = cell_face_start_[c]; k < cell_face_start_[c + 1]; ++k) {
+            sum += cell_face_sign_[k] * face_fluxes[cell_face_[k]];
+        }
+        div[c] = sum;
+    }
+    return div;
+}
+
+
+CollOfScalar EquelleRuntimeCPU::interiorDivergence(const CollOfScalar::ADB& face_fluxes) const
+{
+    return applyStencil(face_fluxes, div_stencil_);
+}
+
+
+CollOfScalarValue EquelleRuntimeCPU::interiorDivergence(const CollOfScalarValue& face_fluxes) const
+{
+    // Same as ops_.div, restricted to interior faces.
+    const int nc = grid_.number_of_cells;
+    CollOfScalarValue div(nc);
+#pragma omp parallel for
+    for (int c = 0; c < nc; ++c) {
+        double sum = 0.0;
+        for (int k = cell_face_start_[c]; k < cell_face_start_[c + 1]; ++k) {
+            const int i = interior_face_index_[cell_face_[k]];
+            if (i >= 0) {
+                sum += cell_face_sign_[k] * face_fluxes[i];
+            }
+        }
+        div[c] = sum;
+    }
+    return div;
 }
 
 
@@ -390,92 +529,147 @@ CollOfBool EquelleRuntimeCPU::isEmpty(const CollOfFace& faces) const
     return retval;
 }
 
-Scalar EquelleRuntimeCPU::minReduce(const CollOfScalar& x) const
+Scalar EquelleRuntimeCPU::minReduce(const CollOfScalar::ADB& x) const
 {
     return x.value().minCoeff();
 }
 
-Scalar EquelleRuntimeCPU::maxReduce(const CollOfScalar& x) const
+Scalar EquelleRuntimeCPU::maxReduce(const CollOfScalar::ADB& x) const
 {
     return x.value().maxCoeff();
 }
 
-Scalar EquelleRuntimeCPU::sumReduce(const CollOfScalar& x) const
+Scalar EquelleRuntimeCPU::sumReduce(const CollOfScalar::ADB& x) const
 {
     return x.value().sum();
 }
 
-Scalar EquelleRuntimeCPU::prodReduce(const CollOfScalar& x) const
+Scalar EquelleRuntimeCPU::prodReduce(const CollOfScalar::ADB& x) const
 {
     return x.value().prod();
 }
 
-CollOfScalar EquelleRuntimeCPU::solveForUpdate(const CollOfScalar& residual) const
+Scalar EquelleRuntimeCPU::minReduce(const CollOfScalarValue& x) const
+{
+    return x.minCoeff();
+}
+
+Scalar EquelleRuntimeCPU::maxReduce(const CollOfScalarValue& x) const
+{
+    return x.maxCoeff();
+}
+
+Scalar EquelleRuntimeCPU::sumReduce(const CollOfScalarValue& x) const
+{
+    return x.sum();
+}
+
+Scalar EquelleRuntimeCPU::prodReduce(const CollOfScalarValue& x) const
+{
+    return x.prod();
+}
+
+const SolverTelemetry& EquelleRuntimeCPU::solverTelemetry() const
+{
+    return telemetry_;
+}
+
+LinearSolver& EquelleRuntimeCPU::linearSolver(const int site)
 {
-    Eigen::SparseMatrix<double, Eigen::RowMajor> matr;
-    residual.derivative()[0].toSparse(matr);
+    std::unique_ptr<LinearSolver>& ls = linsolvers_[site];
+    if (!ls) {
+        ls.reset(new LinearSolver(param_, "newton" + std::to_string(site) + "_"));
+    }
+    return *ls;
+}
 
-    CollOfScalar::V du = CollOfScalar::V::Zero(residual.size());
+
+CollOfScalar::V EquelleRuntimeCPU::solveForUpdate(SparseColMajor& jacobian, const CollOfScalar::V& residual,
+                                                  const int block_size)
+{
+    CollOfScalar::V du;
 
     Opm::time::StopWatch clock;
     clock.start();
 
-    // solve(n, # nonzero values ("val"), ptr to col indices
-    // ("col_ind"), ptr to row locations in val array ("row_ind")
-    // (these two may be swapped, not sure about the naming convention
-    // here...), array of actual values ("val") (I guess... '*sa'...),
-    // rhs, solution)
-    Opm::LinearSolverInterface::LinearSolverReport rep
-            = linsolver_.solve(matr.rows(), matr.nonZeros(),
-                               matr.outerIndexPtr(), matr.innerIndexPtr(), matr.valuePtr(),
-                               residual.value().data(), du.data());
+    linsolver_->solve(jacobian, residual, du, block_size);
 
     if (verbose_ > 2) {
-        std::cout << "        solveForUpdate: Linear solver took: " << clock.secsSinceLast() << " seconds." << std::endl;
-    }
-    if (!rep.converged) {
-        OPM_THROW(std::runtime_error, "Linear solver convergence failure.");
+        std::cout << "        solveForUpdate: Linear solver took: " << clock.secsSinceLast() << " seconds, "
+                  << linsolver_->lastIterations() << " iterations." << std::endl;
     }
     return du;
 }
 
 
-double EquelleRuntimeCPU::twoNorm(const CollOfScalar& vals) const
+void EquelleRuntimeCPU::writeTelemetry() const
+{
+    if (!telemetry_filename_.empty()) {
+        try {
+            telemetry_.write(telemetry_filename_);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to write solver telemetry: " << e.what() << std::endl;
+        }
+    }
+}
+
+
+bool EquelleRuntimeCPU::newtonConverged(const double res_norm, const double initial_res_norm,
+                                        const double update_norm) const
+{
+    return res_norm <= abs_res_tol_
+        || res_norm <= rel_res_tol_ * initial_res_norm
+        || (update_tol_ > 0.0 && update_norm <= update_tol_);
+}
+
+
+double EquelleRuntimeCPU::twoNorm(const CollOfScalar::V& vals) const
+{
+    return vals.matrix().norm();
+}
+
+
+void EquelleRuntimeCPU::output(const String& tag, const double val)
+{
+    if (output_writer_.nextStep(tag) >= 0) {
+        std::cout << tag << " = " << val << std::endl;
+    }
+}
+
+
+void EquelleRuntimeCPU::output(const String& tag, const CollOfScalar::ADB& vals)
 {
-    return vals.value().matrix().norm();
+    // Select before copying the values.
+    const int step = output_writer_.nextStep(tag);
+    if (step >= 0) {
+        output(tag, step, CollOfScalarValue(vals));
+    }
+}
+
+
+void EquelleRuntimeCPU::output(const String& tag, const CollOfScalarValue& vals)
+{
+    const int step = output_writer_.nextStep(tag);
+    if (step >= 0) {
+        output(tag, step, vals);
+    }
 }
 
 
-void EquelleRuntimeCPU::output(const String& tag, const double val) const
+OutputWriter& EquelleRuntimeCPU::outputWriter()
 {
-    std::cout << tag << " = " << val << std::endl;
+    return output_writer_;
 }
 
 
-void EquelleRuntimeCPU::output(const String& tag, const CollOfScalar& vals)
+void EquelleRuntimeCPU::output(const String& tag, const int step, const CollOfScalarValue& vals)
 {
     if (output_to_file_) {
-        int count = -1;
-        auto it = outputcount_.find(tag);
-        if (it == outputcount_.end()) {
-            count = 0;
-            outputcount_[tag] = 1; // should contain the count to be used next time for same tag.
-        } else {
-            count = outputcount_[tag];
-            ++outputcount_[tag];
-        }
-        std::ostringstream fname;
-        fname << tag << "-" << std::setw(5) << std::setfill('0') << count << ".output";
-        std::ofstream file(fname.str().c_str());
-        if (!file) {
-            OPM_THROW(std::runtime_error, "Failed to open " << fname.str());
-        }
-        file.precision(16);
-        std::copy(vals.value().data(), vals.value().data() + vals.size(), std::ostream_iterator<double>(file, "\n"));
+        output_writer_.write(tag, step, vals.data(), vals.size());
     } else {
         std::cout << tag << " =\n";
         for (int i = 0; i < vals.size(); ++i) {
-            std::cout << std::setw(15) << std::left << ( vals.value()[i] ) << " ";
+            std::cout << std::setw(15) << std::left << ( vals[i] ) << " ";
         }
         std::cout << std::endl;
     }
@@ -493,20 +687,19 @@ CollOfFace EquelleRuntimeCPU::inputDomainSubsetOf(const String& name,
                                                   const CollOfFace& face_superset)
 {
     const String filename = param_.get<String>(name + "_filename");
-    std::ifstream is(filename.c_str());
-    if (!is) {
-        OPM_THROW(std::runtime_error, "Could not find file " << filename);
-    }
-    std::istream_iterator<int> beg(is);
-    std::istream_iterator<int> end;
-    CollOfFace data;
-    for (auto it = beg; it != end; ++it) {
-        data.push_back(Face(*it));
-    }
-    if (!is_sorted(data.begin(), data.end())) {
+    const AsciiFile file(filename);
+    std::vector<int> indices(file.size());
+    file.parseTo(indices.data());
+    std::vector<Face> entities;
+    entities.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        entities.push_back(Face(indices[i]));
+    }
+    CollOfFace data(std::move(entities));
+    if (!std::is_sorted(data.begin(), data.end())) {
         OPM_THROW(std::runtime_error, "Input set of faces was not sorted in ascending order.");
     }
-    if (!includes(face_superset.begin(), face_superset.end(), data.begin(), data.end())) {
+    if (!isSubsetOf(data, face_superset)) {
         OPM_THROW(std::runtime_error, "Given faces are not in the assumed subset.");
     }
     return data;
@@ -517,20 +710,19 @@ CollOfCell EquelleRuntimeCPU::inputDomainSubsetOf(const String& name,
                                                   const CollOfCell& cell_superset)
 {
     const String filename = param_.get<String>(name + "_filename");
-    std::ifstream is(filename.c_str());
-    if (!is) {
-        OPM_THROW(std::runtime_error, "Could not find file " << filename);
-    }
-    std::istream_iterator<int> beg(is);
-    std::istream_iterator<int> end;
-    CollOfCell data;
-    for (auto it = beg; it != end; ++it) {
-        data.push_back(Cell(*it));
-    }
-    if (!is_sorted(data.begin(), data.end())) {
+    const AsciiFile file(filename);
+    std::vector<int> indices(file.size());
+    file.parseTo(indices.data());
+    std::vector<Cell> entities;
+    entities.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        entities.push_back(Cell(indices[i]));
+    }
+    CollOfCell data(std::move(entities));
+    if (!std::is_sorted(data.begin(), data.end())) {
         OPM_THROW(std::runtime_error, "Input set of cells was not sorted in ascending order.");
     }
-    if (!includes(cell_superset.begin(), cell_superset.end(), data.begin(), data.end())) {
+    if (!isSubsetOf(data, cell_superset)) {
         OPM_THROW(std::runtime_error, "Given cells are not in the assumed subset.");
     }
     return data;
@@ -540,13 +732,15 @@ CollOfCell EquelleRuntimeCPU::inputDomainSubsetOf(const String& name,
 SeqOfScalar EquelleRuntimeCPU::inputSequenceOfScalar(const String& name)
 {
     const String filename = param_.get<String>(name + "_filename");
-    std::ifstream is(filename.c_str());
-    if (!is) {
-        OPM_THROW(std::runtime_error, "Could not find file " << filename);
-    }
-    std::istream_iterator<Scalar> beg(is);
-    std::istream_iterator<Scalar> end;
-    SeqOfScalar data(beg, end);
+    if (isBinaryInput(param_.getDefault<String>(name + "_format", "auto"), filename)) {
+        const FieldFile file(filename);
+        SeqOfScalar data(file.size());
+        file.copyTo(data.data());
+        return data;
+    }
+    const AsciiFile file(filename);
+    SeqOfScalar data(file.size());
+    file.parseTo(data.data());
     return data;
 }
 
@@ -562,12 +756,216 @@ void EquelleRuntimeCPU::ensureGridDimensionMin(const int minimum_grid_dimension)
 
 
 
-CollOfScalar EquelleRuntimeCPU::singlePrimaryVariable(const CollOfScalar& initial_values)
+int EquelleRuntimeCPU::subsetIndexCacheHits() const
+{
+    return subset_index_cache_hits_;
+}
+
+
+
+int EquelleRuntimeCPU::subsetIndexCacheMisses() const
 {
-    std::vector<int> block_pattern;
-    block_pattern.push_back(initial_values.size());
-    // Syntax below is: CollOfScalar::variable(block index, initialized from, block structure)
-    return CollOfScalar::variable(0, initial_values.value(), block_pattern);
+    return subset_index_cache_misses_;
+}
+
+
+
+// Note that this will not produce what some would consider the expected results for a 1D grid realized as a 2D grid of dimension (n, 1) or (1, n), since all cells
+// of such a grid are boundary cells.
+// That points out that communicating the grid concepts is very important.
+void EquelleRuntimeCPU::initTopology()
+{
+    const int nc = grid_.number_of_cells;
+    const int nf = grid_.number_of_faces;
+
+    // The interior faces are taken from HelperOps, so that they are
+    // consistent with the ordering used by gradient() and divergence().
+    // All other faces are boundary faces.
+    const int nif = ops_.internal_faces.size();
+    std::vector<char> is_interior_face(nf, 0);
+    interior_faces_.clear();
+    interior_faces_.reserve(nif);
+    for (int i = 0; i < nif; ++i) {
+        interior_faces_.emplace_back(ops_.internal_faces[i]);
+        is_interior_face[ops_.internal_faces[i]] = 1;
+    }
+    interior_face_index_.assign(nf, -1);
+    for (int i = 0; i < nif; ++i) {
+        interior_face_index_[ops_.internal_faces[i]] = i;
+    }
+    boundary_faces_.clear();
+    boundary_faces_.reserve(nf - nif);
+    for (int f = 0; f < nf; ++f) {
+        if (!is_interior_face[f]) {
+            boundary_faces_.emplace_back(f);
+        }
+    }
+
+    // A cell is a boundary cell if any of its faces has an outer neighbour.
+    std::vector<char> is_boundary_cell(nc, 0);
+    for (int f = 0; f < nf; ++f) {
+        const int c1 = grid_.face_cells[2*f];
+        const int c2 = grid_.face_cells[2*f + 1];
+        if (c1 == Boundary::outer || c2 == Boundary::outer) {
+            if (c1 >= 0) {
+                is_boundary_cell[c1] = 1;
+            }
+            if (c2 >= 0) {
+                is_boundary_cell[c2] = 1;
+            }
+        }
+    }
+
+    boundary_cells_.clear();
+    interior_cells_.clear();
+    for (int c = 0; c < nc; ++c) {
+        if (is_boundary_cell[c]) {
+            boundary_cells_.emplace_back(c);
+        } else {
+            interior_cells_.emplace_back(c);
+        }
+    }
+
+    // The faces of each cell, in increasing order, with sign 1 where
+    // the cell is the first cell of the face and -1 where it is the
+    // second.
+    cell_face_start_.assign(nc + 1, 0);
+    for (int f = 0; f < nf; ++f) {
+        for (int side = 0; side < 2; ++side) {
+            const int c = grid_.face_cells[2*f + side];
+            if (c >= 0) {
+                ++cell_face_start_[c + 1];
+            }
+        }
+    }
+    std::partial_sum(cell_face_start_.begin(), cell_face_start_.end(), cell_face_start_.begin());
+    cell_face_.resize(cell_face_start_[nc]);
+    cell_face_sign_.resize(cell_face_start_[nc]);
+    std::vector<int> pos(cell_face_start_.begin(), cell_face_start_.end() - 1);
+    for (int f = 0; f < nf; ++f) {
+        for (int side = 0; side < 2; ++side) {
+            const int c = grid_.face_cells[2*f + side];
+            if (c >= 0) {
+                cell_face_[pos[c]] = f;
+                cell_face_sign_[pos[c]] = side == 0 ? 1.0 : -1.0;
+                ++pos[c];
+            }
+        }
+    }
+
+    // Stencils of the gradients, from each cell to its interior faces,
+    // and of the divergences, from each face to its cells.
+    grad_stencil_.rows = nif;
+    ngrad_stencil_.rows = nif;
+    grad_stencil_.start.assign(1, 0);
+    grad_stencil_.target.clear();
+    grad_stencil_.weight.clear();
+    for (int c = 0; c < nc; ++c) {
+        for (int k = cell_face_start_[c]; k < cell_face_start_[c + 1]; ++k) {
+            const int i = interior_face_index_[cell_face_[k]];
+            if (i >= 0) {
+                grad_stencil_.target.push_back(i);
+                grad_stencil_.weight.push_back(-cell_face_sign_[k]);
+            }
+        }
+        grad_stencil_.start.push_back(grad_stencil_.target.size());
+    }
+    ngrad_stencil_.start = grad_stencil_.start;
+    ngrad_stencil_.target = grad_stencil_.target;
+    ngrad_stencil_.weight.resize(grad_stencil_.weight.size());
+    for (size_t k = 0; k < ngrad_stencil_.weight.size(); ++k) {
+        ngrad_stencil_.weight[k] = -grad_stencil_.weight[k];
+    }
+    div_stencil_ = faceStencil(grid_, ops_.internal_faces, nc);
+    std::vector<int> all_face_indices(nf);
+    std::iota(all_face_indices.begin(), all_face_indices.end(), 0);
+    fulldiv_stencil_ = faceStencil(grid_, all_face_indices, nc);
+
+    // First and second cells of the face sets used by Equelle programs.
+    // Copies of these share storage, so firstCell() and secondCell()
+    // return them without allocating, and they keep their identity in
+    // the subset index cache.
+    const CollOfFace all_faces = allFaces();
+    for (int side = 0; side < 2; ++side) {
+        all_face_cells_[side] = faceCells(grid_, all_faces, side);
+        interior_face_cells_[side] = faceCells(grid_, interior_faces_, side);
+        boundary_face_cells_[side] = faceCells(grid_, boundary_faces_, side);
+    }
+}
+
+
+void EquelleRuntimeCPU::initGeometry()
+{
+    const int nc = grid_.number_of_cells;
+    const int nf = grid_.number_of_faces;
+    const int dim = grid_.dimensions;
+    cell_centroids_ = toColumns(grid_.cell_centroids, nc, dim);
+    face_centroids_ = toColumns(grid_.face_centroids, nf, dim);
+    // Since the UnstructuredGrid uses the unorthodox convention that face
+    // normals are scaled with the face areas, we must renormalize them.
+    face_unit_normals_ = toColumns(grid_.face_normals, nf, dim);
+    face_unit_normals_.colwise() /= face_unit_normals_.matrix().rowwise().norm().array();
+    face_areas_ = Eigen::Map<const CollOfScalar::V>(grid_.face_areas, nf);
+    cell_volumes_ = Eigen::Map<const CollOfScalar::V>(grid_.cell_volumes, nc);
+}
+
+
+const CollOfCell* EquelleRuntimeCPU::precomputedFaceCells(const CollOfFace& faces, const int side) const
+{
+    if (faces.isFull()) {
+        return &all_face_cells_[side];
+    }
+    if (faces.empty()) {
+        return nullptr;
+    }
+    if (faces.id() == interior_faces_.id()) {
+        return &interior_face_cells_[side];
+    }
+    if (faces.id() == boundary_faces_.id()) {
+        return &boundary_face_cells_[side];
+    }
+    return nullptr;
+}
+
+
+
+std::vector<CollOfScalar> EquelleRuntimeCPU::primaryVariables(const CollOfScalar::V& u,
+                                                             const std::vector<int>& block_pattern,
+                                                             const CollOfScalar::V* tangent)
+{
+    const int num = block_pattern.size();
+    std::vector<CollOfScalar::V> parts(num);
+    int start = 0;
+    for (int i = 0; i < num; ++i) {
+        parts[i] = u.segment(start, block_pattern[i]);
+        start += block_pattern[i];
+    }
+    std::vector<CollOfScalar> vars(num);
+    if (!tangent) {
+        std::vector<CollOfScalar::ADB> adb_vars = CollOfScalar::ADB::variables(parts);
+        for (int i = 0; i < num; ++i) {
+            vars[i] = std::move(adb_vars[i]);
+        }
+        return vars;
+    }
+    // A single jacobian column, holding the nonzero tangent elements.
+    start = 0;
+    for (int i = 0; i < num; ++i) {
+        const int sz = block_pattern[i];
+        SparseColMajor column(sz, 1);
+        column.reserve(Eigen::VectorXi::Constant(1, sz));
+        for (int e = 0; e < sz; ++e) {
+            const double t = (*tangent)[start + e];
+            if (t != 0.0) {
+                column.insert(e, 0) = t;
+            }
+        }
+        column.makeCompressed();
+        std::vector<CollOfScalar::M> jac(1, CollOfScalar::M(std::move(column)));
+        vars[i] = CollOfScalar::ADB::function(std::move(parts[i]), std::move(jac));
+        start += sz;
+    }
+    return vars;
 }
 
 } // equelle-namespace
@@ -0,0 +1,449 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/FieldFile.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace equelle {
+
+
+namespace
+{
+    const char field_magic[8] = { 'E', 'Q', 'L', 'F', 'I', 'E', 'L', 'D' };
+    const std::uint32_t field_version = 1;
+
+    struct FieldHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t type;
+        std::uint32_t entity;
+        std::uint32_t reserved;
+        std::uint64_t count;
+    };
+    static_assert(sizeof(FieldHeader) == 32, "Field file header must be 32 bytes.");
+
+    std::size_t valueBytes(const FieldType type)
+    {
+        return type == FieldType::Float64 ? sizeof(double) : sizeof(float);
+    }
+
+    /// Maps the whole file read-only and sets size to its length. Returns
+    /// null for empty files, which cannot be mapped.
+    char* mapFile(const std::string& filename, std::size_t& size)
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            OPM_THROW(std::runtime_error, "Could not find file " << filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            OPM_THROW(std::runtime_error, "Could not read file " << filename);
+        }
+        size = st.st_size;
+        if (size == 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            OPM_THROW(std::runtime_error, "Could not map file " << filename);
+        }
+        return static_cast<char*>(map);
+    }
+
+    void unmapFile(char* map, const std::size_t size)
+    {
+        if (map) {
+            ::munmap(map, size);
+        }
+    }
+
+    /// Bytes per chunk of an AsciiFile, small enough to balance the
+    /// threads and large enough to make the chunk overhead negligible.
+    const std::size_t ascii_chunk_bytes = 1 << 20;
+
+    bool isSpace(const char c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    bool isDigit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    /// Parses the token from b to e with strtod(), which needs it null
+    /// terminated.
+    bool parseWithStrtod(const char* b, const char* e, double& x)
+    {
+        const std::string token(b, e);
+        char* end = nullptr;
+        x = std::strtod(token.c_str(), &end);
+        return end == token.c_str() + token.size();
+    }
+
+    /// Parses the token from b to e. Decimal numbers with at most 19
+    /// significant digits that are exact in a double and whose scale is
+    /// an exact power of ten are computed directly; the single rounding
+    /// of the division or multiplication then gives the correctly rounded
+    /// result (Clinger's fast path). Others go through strtod().
+    bool parseNumber(const char* b, const char* e, double& x)
+    {
+        static const double pow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const char* p = b;
+        const bool negative = p != e && *p == '-';
+        if (p != e && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        int scale = 0;
+        bool any_digit = false;
+        bool truncated = false;
+        for (; p != e && isDigit(*p); ++p) {
+            any_digit = true;
+            if (digits < 19) {
+                mantissa = 10 * mantissa + (*p - '0');
+                digits += mantissa != 0;
+            } else {
+                ++scale;
+                truncated = truncated || *p != '0';
+            }
+        }
+        if (p != e && *p == '.') {
+            for (++p; p != e && isDigit(*p); ++p) {
+                any_digit = true;
+                if (digits < 19) {
+                    mantissa = 10 * mantissa + (*p - '0');
+                    digits += mantissa != 0;
+                    --scale;
+                } else {
+                    truncated = truncated || *p != '0';
+                }
+            }
+        }
+        if (!any_digit) {
+            // Also inf and nan, which strtod() knows.
+            return parseWithStrtod(b, e, x);
+        }
+        if (p != e && (*p == 'e' || *p == 'E')) {
+            ++p;
+            const bool negative_exp = p != e && *p == '-';
+            if (p != e && (*p == '-' || *p == '+')) {
+                ++p;
+            }
+            if (p == e) {
+                return false;
+            }
+            int exponent = 0;
+            for (; p != e && isDigit(*p); ++p) {
+                exponent = std::min(10 * exponent + (*p - '0'), 100000);
+            }
+            scale += negative_exp ? -exponent : exponent;
+        }
+        if (p != e) {
+            return false;
+        }
+        if (truncated || mantissa > (std::uint64_t(1) << 53) || scale < -22 || scale > 22) {
+            return parseWithStrtod(b, e, x);
+        }
+        x = double(mantissa);
+        x = scale < 0 ? x / pow10[-scale] : x * pow10[scale];
+        x = negative ? -x : x;
+        return true;
+    }
+
+    /// Parses the token from b to e as a decimal int.
+    bool parseNumber(const char* b, const char* e, int& x)
+    {
+        const char* p = b;
+        const bool negative = p != e && *p == '-';
+        if (p != e && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+        if (p == e) {
+            return false;
+        }
+        long long value = 0;
+        for (; p != e; ++p) {
+            if (!isDigit(*p)) {
+                return false;
+            }
+            value = 10 * value + (*p - '0');
+            if (value > std::numeric_limits<int>::max() + 1LL) {
+                return false;
+            }
+        }
+        value = negative ? -value : value;
+        if (value > std::numeric_limits<int>::max()) {
+            return false;
+        }
+        x = int(value);
+        return true;
+    }
+} // anonymous namespace
+
+
+
+FieldFile::FieldFile(const std::string& filename)
+    : filename_(filename),
+      map_(nullptr),
+      map_size_(0),
+      size_(0),
+      type_(FieldType::Float64),
+      entity_(FieldEntity::None),
+      values_(nullptr)
+{
+    map_ = mapFile(filename, map_size_);
+    if (map_size_ < sizeof(FieldHeader)) {
+        unmapFile(map_, map_size_);
+        map_ = nullptr;
+        OPM_THROW(std::runtime_error, "File " << filename << " is too short to be a field file.");
+    }
+
+    FieldHeader header;
+    std::memcpy(&header, map_, sizeof(header));
+    const char* problem = nullptr;
+    if (std::memcmp(header.magic, field_magic, sizeof(field_magic)) != 0) {
+        problem = "is not a field file";
+    } else if (header.version != field_version) {
+        problem = "has an unsupported field file version";
+    } else if (header.type > std::uint32_t(FieldType::Float32)) {
+        problem = "has an unknown value type";
+    } else if (header.entity > std::uint32_t(FieldEntity::Faces)) {
+        problem = "has an unknown entity kind";
+    } else if (header.count > std::uint64_t(std::numeric_limits<int>::max())) {
+        problem = "has too many values";
+    } else if (sizeof(FieldHeader) + header.count * valueBytes(FieldType(header.type)) > map_size_) {
+        problem = "is shorter than its header says";
+    }
+    if (problem) {
+        unmapFile(map_, map_size_);
+        map_ = nullptr;
+        OPM_THROW(std::runtime_error, "File " << filename << " " << problem << ".");
+    }
+    size_ = header.count;
+    type_ = FieldType(header.type);
+    entity_ = FieldEntity(header.entity);
+    values_ = static_cast<const char*>(map_) + sizeof(FieldHeader);
+}
+
+
+FieldFile::~FieldFile()
+{
+    unmapFile(map_, map_size_);
+}
+
+
+int FieldFile::size() const
+{
+    return size_;
+}
+
+
+FieldType FieldFile::type() const
+{
+    return type_;
+}
+
+
+FieldEntity FieldFile::entity() const
+{
+    return entity_;
+}
+
+
+const double* FieldFile::data() const
+{
+    if (type_ != FieldType::Float64) {
+        OPM_THROW(std::runtime_error, "File " << filename_ << " does not hold Float64 values.");
+    }
+    return static_cast<const double*>(values_);
+}
+
+
+double FieldFile::value(const int i) const
+{
+    if (type_ == FieldType::Float64) {
+        return static_cast<const double*>(values_)[i];
+    } else {
+        return static_cast<const float*>(values_)[i];
+    }
+}
+
+
+void FieldFile::copyTo(double* out) const
+{
+    if (type_ == FieldType::Float64) {
+        std::memcpy(out, values_, size_ * sizeof(double));
+    } else {
+        const float* v = static_cast<const float*>(values_);
+        for (int i = 0; i < size_; ++i) {
+            out[i] = v[i];
+        }
+    }
+}
+
+
+void FieldFile::write(const std::string& filename, const double* values,
+                      const int n, const FieldEntity entity)
+{
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file) {
+        OPM_THROW(std::runtime_error, "Failed to open " << filename);
+    }
+    FieldHeader header;
+    std::memcpy(header.magic, field_magic, sizeof(field_magic));
+    header.version = field_version;
+    header.type = std::uint32_t(FieldType::Float64);
+    header.entity = std::uint32_t(entity);
+    header.reserved = 0;
+    header.count = n;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(values), n * sizeof(double));
+    if (!file) {
+        OPM_THROW(std::runtime_error, "Failed to write " << filename);
+    }
+}
+
+
+
+AsciiFile::AsciiFile(const std::string& filename)
+    : filename_(filename),
+      map_(nullptr),
+      map_size_(0)
+{
+    map_ = mapFile(filename, map_size_);
+    // Chunks start at whitespace, so that no number is split.
+    chunk_start_.push_back(0);
+    for (std::size_t pos = ascii_chunk_bytes; pos < map_size_; pos += ascii_chunk_bytes) {
+        while (pos < map_size_ && !isSpace(map_[pos])) {
+            ++pos;
+        }
+        if (pos < map_size_ && pos > chunk_start_.back()) {
+            chunk_start_.push_back(pos);
+        }
+    }
+    chunk_start_.push_back(map_size_);
+
+    const int num_chunks = chunk_start_.size() - 1;
+    chunk_offset_.assign(num_chunks + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < num_chunks; ++c) {
+        int count = 0;
+        bool in_token = false;
+        for (std::size_t pos = chunk_start_[c]; pos < chunk_start_[c + 1]; ++pos) {
+            const bool space = isSpace(map_[pos]);
+            count += in_token && space;
+            in_token = !space;
+        }
+        chunk_offset_[c + 1] = count + in_token;
+    }
+    for (int c = 0; c < num_chunks; ++c) {
+        chunk_offset_[c + 1] += chunk_offset_[c];
+    }
+}
+
+
+AsciiFile::~AsciiFile()
+{
+    unmapFile(map_, map_size_);
+}
+
+
+int AsciiFile::size() const
+{
+    return chunk_offset_.back();
+}
+
+
+void AsciiFile::parseTo(double* out) const
+{
+    parseChunks(out);
+}
+
+
+void AsciiFile::parseTo(int* out) const
+{
+    parseChunks(out);
+}
+
+
+template <typename T>
+void AsciiFile::parseChunks(T* out) const
+{
+    const int num_chunks = chunk_start_.size() - 1;
+    // Start of the first bad token of each chunk, or the chunk end.
+    std::vector<std::size_t> bad(chunk_start_.begin() + 1, chunk_start_.end());
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < num_chunks; ++c) {
+        const char* p = map_ + chunk_start_[c];
+        const char* end = map_ + chunk_start_[c + 1];
+        T* dest = out + chunk_offset_[c];
+        for (;;) {
+            while (p != end && isSpace(*p)) {
+                ++p;
+            }
+            if (p == end) {
+                break;
+            }
+            const char* token = p;
+            while (p != end && !isSpace(*p)) {
+                ++p;
+            }
+            if (!parseNumber(token, p, *dest++)) {
+                bad[c] = token - map_;
+                break;
+            }
+        }
+    }
+    for (int c = 0; c < num_chunks; ++c) {
+        if (bad[c] != chunk_start_[c + 1]) {
+            const char* token = map_ + bad[c];
+            const char* file_end = map_ + map_size_;
+            const char* token_end = std::find_if(token, file_end, isSpace);
+            OPM_THROW(std::runtime_error, "Could not read the number " << std::string(token, token_end)
+                      << " in file " << filename_);
+        }
+    }
+}
+
+
+
+bool isBinaryInput(const std::string& format, const std::string& filename)
+{
+    if (format == "binary") {
+        return true;
+    } else if (format == "ascii") {
+        return false;
+    } else if (format != "auto") {
+        OPM_THROW(std::runtime_error, "Illegal input format " << format
+                  << " for " << filename << ", use binary, ascii or auto.");
+    }
+    const std::string extension = ".eqf";
+    return filename.size() >= extension.size()
+        && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+
+} // namespace equelle
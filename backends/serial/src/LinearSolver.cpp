@@ -0,0 +1,360 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/LinearSolver.hpp"
+#include "equelle/KrylovSolvers.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace equelle {
+
+
+namespace
+{
+    /// The preconditioner named by parameter param_name, or null for none.
+    Preconditioner* makePreconditioner(const std::string& name, const std::string& param_name)
+    {
+        if (name == "ILU0") {
+            return new BlockILU0Preconditioner;
+        } else if (name == "Jacobi") {
+            return new BlockJacobiPreconditioner;
+        } else if (name == "AMG") {
+            return new AMGPreconditioner;
+        } else if (name != "none") {
+            OPM_THROW(std::runtime_error, "Illegal input " << name << " for " << param_name
+                      << ", use ILU0, Jacobi, AMG or none.");
+        }
+        return 0;
+    }
+
+    /// The parameter prefix + name if given, else the parameter name,
+    /// else the default.
+    template <typename T>
+    T parameter(const Opm::ParameterGroup& param, const std::string& prefix,
+                const std::string& name, const T& default_value)
+    {
+        return param.getDefault(prefix + name, param.getDefault(name, default_value));
+    }
+} // anonymous namespace
+
+
+LinearSolver::LinearSolver(const Opm::ParameterGroup& param,
+                           const std::string& prefix)
+    : method_(Krylov),
+      krylov_(GMRes),
+      tol_(parameter(param, prefix, "solver_tol", 1e-8)),
+      max_iter_(parameter(param, prefix, "solver_max_iter", 1000)),
+      restart_(parameter(param, prefix, "gmres_restart", 30)),
+      rebuild_iterations_(parameter(param, prefix, "preconditioner_rebuild_iterations", 0)),
+      preconditioner_current_(false),
+      warm_start_(true),
+      pattern_rows_(-1),
+      pattern_block_size_(0),
+      last_iterations_(0),
+      preconditioner_iterations_(0),
+      last_setup_time_(0.0),
+      pattern_reuses_(0),
+      pattern_rebuilds_(0),
+      preconditioner_setups_(0),
+      preconditioner_reuses_(0)
+{
+    const std::string solver = parameter<std::string>(param, prefix, "solver", "opm");
+    if (solver == "opm") {
+        method_ = OpmFactory;
+        opm_solver_.reset(new Opm::LinearSolverFactory(param));
+        // The OPM solver has its own tolerance parameters, keep them as
+        // the base tolerance.
+        tol_ = opm_solver_->getTolerance();
+    } else if (solver == "SparseLU") {
+        method_ = SparseLU;
+    } else if (solver == "CG") {
+        krylov_ = CG;
+    } else if (solver == "BiCGStab") {
+        krylov_ = BiCGStab;
+    } else if (solver != "GMRes") {
+        OPM_THROW(std::runtime_error, "Illegal input " << solver
+                  << " for solver, use opm, SparseLU, CG, BiCGStab or GMRes.");
+    }
+    if (method_ == Krylov) {
+        const std::string precond = parameter<std::string>(param, prefix, "preconditioner", "ILU0");
+        preconditioner_.reset(makePreconditioner(precond, "preconditioner"));
+        if (!preconditioner_) {
+            preconditioner_.reset(new IdentityPreconditioner);
+        }
+    }
+    if (restart_ < 1) {
+        OPM_THROW(std::runtime_error, "gmres_restart must be positive, got " << restart_ << ".");
+    }
+    const std::string guess = parameter<std::string>(param, prefix, "initial_guess", "previous");
+    if (guess == "zero") {
+        warm_start_ = false;
+    } else if (guess != "previous") {
+        OPM_THROW(std::runtime_error, "Illegal input " << guess << " for initial_guess, use previous or zero.");
+    }
+    const std::string jfnk_precond = parameter<std::string>(param, prefix, "jfnk_preconditioner", "none");
+    jfnk_preconditioner_.reset(makePreconditioner(jfnk_precond, "jfnk_preconditioner"));
+}
+
+
+void LinearSolver::solve(SparseColMajor& jacobian,
+                         const CollOfScalar::V& rhs,
+                         CollOfScalar::V& x,
+                         const int block_size)
+{
+    matrix_.swap(jacobian);
+    matrix_.makeCompressed();
+    const bool new_pattern = updatePattern(block_size);
+    x.resize(rhs.size());
+    last_iterations_ = 1;
+    last_setup_time_ = 0.0;
+
+    switch (method_) {
+    case OpmFactory: {
+        if (new_pattern) {
+            buildCsrPattern();
+        } else {
+            refillCsrValues();
+        }
+        const Opm::LinearSolverInterface::LinearSolverReport rep
+            = opm_solver_->solve(csr_.rows(), csr_.nonZeros(),
+                                 csr_.outerIndexPtr(), csr_.innerIndexPtr(), csr_.valuePtr(),
+                                 rhs.data(), x.data());
+        if (!rep.converged) {
+            OPM_THROW(std::runtime_error, "Linear solver convergence failure.");
+        }
+        break;
+    }
+    case SparseLU: {
+        Opm::time::StopWatch clock;
+        clock.start();
+        if (new_pattern) {
+            lu_.analyzePattern(matrix_);
+        }
+        lu_.factorize(matrix_);
+        last_setup_time_ = clock.secsSinceStart();
+        if (lu_.info() != Eigen::Success) {
+            OPM_THROW(std::runtime_error, "Sparse LU factorization failed: " << lu_.lastErrorMessage());
+        }
+        x = lu_.solve(rhs.matrix()).array();
+        break;
+    }
+    case Krylov: {
+        if (new_pattern) {
+            bsr_.setPattern(matrix_, block_size);
+        } else {
+            bsr_.setValues(matrix_);
+        }
+        const bool reuse = preconditionerReusable(new_pattern, rhs.size());
+        if (reuse) {
+            ++preconditioner_reuses_;
+        } else {
+            setupPreconditioner(*preconditioner_);
+        }
+        Eigen::VectorXd b(rhs.size());
+        bsr_.toBlockOrder(rhs.data(), b.data());
+        Eigen::VectorXd z = Eigen::VectorXd::Zero(rhs.size());
+        if (warm_start_ && previous_solution_.size() == rhs.size()) {
+            bsr_.toBlockOrder(previous_solution_.data(), z.data());
+            checkInitialGuess(bsr_, b, z);
+        }
+        const Eigen::VectorXd z0 = z;
+        KrylovReport rep = krylovSolve(bsr_, *preconditioner_, b, z, reuse ? rebuild_iterations_ : max_iter_);
+        last_iterations_ = rep.iterations;
+        preconditioner_iterations_ = rep.iterations;
+        if (!rep.converged && reuse) {
+            // The kept preconditioner is too far off, start over with a new one.
+            setupPreconditioner(*preconditioner_);
+            z = z0;
+            rep = krylovSolve(bsr_, *preconditioner_, b, z, max_iter_);
+            last_iterations_ += rep.iterations;
+            preconditioner_iterations_ = rep.iterations;
+        }
+        if (!rep.converged) {
+            OPM_THROW(std::runtime_error, "Linear solver convergence failure, residual reduced by "
+                      << rep.residual_reduction << " in " << rep.iterations << " iterations.");
+        }
+        bsr_.fromBlockOrder(z.data(), x.data());
+        break;
+    }
+    }
+    if (warm_start_) {
+        previous_solution_ = x;
+    }
+}
+
+
+void LinearSolver::setupJacobianFreePreconditioner(SparseColMajor& jacobian, const int block_size)
+{
+    matrix_.swap(jacobian);
+    matrix_.makeCompressed();
+    if (updatePattern(block_size)) {
+        bsr_.setPattern(matrix_, block_size);
+    } else {
+        bsr_.setValues(matrix_);
+    }
+    setupPreconditioner(*jfnk_preconditioner_);
+}
+
+
+void LinearSolver::applyJacobianFreePreconditioner(const double* r, double* z, const int n) const
+{
+    if (!jfnk_preconditioner_) {
+        std::copy(r, r + n, z);
+        return;
+    }
+    r_block_.resize(n);
+    z_block_.resize(n);
+    bsr_.toBlockOrder(r, r_block_.data());
+    jfnk_preconditioner_->apply(r_block_.data(), z_block_.data());
+    bsr_.fromBlockOrder(z_block_.data(), z);
+}
+
+
+void LinearSolver::setTolerance(const double tol)
+{
+    tol_ = tol;
+    if (opm_solver_) {
+        opm_solver_->setTolerance(tol);
+    }
+}
+
+
+double LinearSolver::tolerance() const
+{
+    return tol_;
+}
+
+
+int LinearSolver::lastIterations() const
+{
+    return last_iterations_;
+}
+
+
+double LinearSolver::lastSetupTime() const
+{
+    return last_setup_time_;
+}
+
+
+int LinearSolver::patternReuses() const
+{
+    return pattern_reuses_;
+}
+
+
+int LinearSolver::patternRebuilds() const
+{
+    return pattern_rebuilds_;
+}
+
+
+int LinearSolver::preconditionerSetups() const
+{
+    return preconditioner_setups_;
+}
+
+
+int LinearSolver::preconditionerReuses() const
+{
+    return preconditioner_reuses_;
+}
+
+
+bool LinearSolver::preconditionerReusable(const bool new_pattern, const int size) const
+{
+    return rebuild_iterations_ > 0
+        && preconditioner_current_
+        && !new_pattern
+        && bsr_.blockRows() * bsr_.blockSize() == size
+        && preconditioner_iterations_ <= rebuild_iterations_;
+}
+
+
+void LinearSolver::setupPreconditioner(Preconditioner& prec)
+{
+    Opm::time::StopWatch clock;
+    clock.start();
+    prec.setup(bsr_);
+    last_setup_time_ += clock.secsSinceStart();
+    preconditioner_current_ = true;
+    ++preconditioner_setups_;
+}
+
+
+bool LinearSolver::updatePattern(const int block_size)
+{
+    const int cols = matrix_.cols();
+    const int nnz = matrix_.nonZeros();
+    const int* outer = matrix_.outerIndexPtr();
+    const int* inner = matrix_.innerIndexPtr();
+    const bool same = matrix_.rows() == pattern_rows_
+        && block_size == pattern_block_size_
+        && int(pattern_outer_.size()) == cols + 1
+        && int(pattern_inner_.size()) == nnz
+        && std::equal(outer, outer + cols + 1, pattern_outer_.begin())
+        && std::equal(inner, inner + nnz, pattern_inner_.begin());
+    if (same) {
+        ++pattern_reuses_;
+        return false;
+    }
+    pattern_rows_ = matrix_.rows();
+    pattern_block_size_ = block_size;
+    pattern_outer_.assign(outer, outer + cols + 1);
+    pattern_inner_.assign(inner, inner + nnz);
+    preconditioner_current_ = false;
+    ++pattern_rebuilds_;
+    return true;
+}
+
+
+void LinearSolver::buildCsrPattern()
+{
+    // A counting sort of the entries by row. Visiting the columns in
+    // order keeps the entries of each row sorted.
+    const int rows = matrix_.rows();
+    const int cols = matrix_.cols();
+    const int nnz = matrix_.nonZeros();
+    const int* outer = matrix_.outerIndexPtr();
+    const int* inner = matrix_.innerIndexPtr();
+    csr_.resize(rows, cols);
+    csr_.resizeNonZeros(nnz);
+    int* csr_outer = csr_.outerIndexPtr();
+    int* csr_inner = csr_.innerIndexPtr();
+    std::fill(csr_outer, csr_outer + rows + 1, 0);
+    for (int k = 0; k < nnz; ++k) {
+        ++csr_outer[inner[k] + 1];
+    }
+    for (int r = 0; r < rows; ++r) {
+        csr_outer[r + 1] += csr_outer[r];
+    }
+    std::vector<int> cursor(csr_outer, csr_outer + rows);
+    csr_position_.resize(nnz);
+    for (int c = 0; c < cols; ++c) {
+        for (int k = outer[c]; k < outer[c + 1]; ++k) {
+            const int pos = cursor[inner[k]]++;
+            csr_inner[pos] = c;
+            csr_position_[k] = pos;
+        }
+    }
+    refillCsrValues();
+}
+
+
+void LinearSolver::refillCsrValues()
+{
+    const int nnz = matrix_.nonZeros();
+    const double* val = matrix_.valuePtr();
+    double* csr_val = csr_.valuePtr();
+#pragma omp parallel for
+    for (int k = 0; k < nnz; ++k) {
+        csr_val[csr_position_[k]] = val[k];
+    }
+}
+
+
+} // namespace equelle
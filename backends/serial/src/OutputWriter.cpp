@@ -0,0 +1,489 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/OutputWriter.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#ifdef EQUELLE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace equelle {
+
+
+namespace
+{
+    const char container_magic[8] = { 'E', 'Q', 'L', 'O', 'U', 'T', 'P', 'T' };
+    const std::uint32_t container_version = 1;
+
+    /// Buffer size of each container file. Records are written in
+    /// pieces this large, and never one value at a time.
+    const std::size_t container_buffer_bytes = 4 << 20;
+
+    struct RecordHeader
+    {
+        std::uint32_t step;
+        std::uint32_t tag_length;
+        std::uint64_t count;
+        std::uint64_t stored_bytes;
+    };
+    static_assert(sizeof(RecordHeader) == 24, "Output record header must be 24 bytes.");
+
+    /// Number of zero bytes padding a tag of the given length.
+    std::size_t tagPadding(const std::size_t tag_length)
+    {
+        return (8 - tag_length % 8) % 8;
+    }
+
+    /// XDMF Mixed topology codes.
+    const int xdmf_polygon = 3;
+    const int xdmf_polyhedron = 16;
+
+    /// Appends cell c of a 2D grid as an XDMF polygon: the code, the node
+    /// count and the nodes in counterclockwise order, found by chaining
+    /// the edges of the cell.
+    void appendPolygon(const UnstructuredGrid& grid, const int c, std::vector<int>& topology)
+    {
+        std::vector<std::pair<int, int> > edges;
+        for (int i = grid.cell_facepos[c]; i < grid.cell_facepos[c + 1]; ++i) {
+            const int* nodes = grid.face_nodes + grid.face_nodepos[grid.cell_faces[i]];
+            edges.push_back(std::make_pair(nodes[0], nodes[1]));
+        }
+        std::vector<bool> used(edges.size(), false);
+        std::vector<int> nodes(1, edges[0].first);
+        used[0] = true;
+        int next = edges[0].second;
+        while (next != nodes[0]) {
+            nodes.push_back(next);
+            size_t e = 0;
+            while (e < edges.size() && (used[e] || (edges[e].first != next && edges[e].second != next))) {
+                ++e;
+            }
+            if (e == edges.size()) {
+                OPM_THROW(std::runtime_error, "Cell " << c << " is not a closed polygon.");
+            }
+            used[e] = true;
+            next = edges[e].first == next ? edges[e].second : edges[e].first;
+        }
+        double area = 0.0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const double* p = grid.node_coordinates + 2 * nodes[i];
+            const double* q = grid.node_coordinates + 2 * nodes[(i + 1) % nodes.size()];
+            area += p[0] * q[1] - q[0] * p[1];
+        }
+        if (area < 0.0) {
+            std::reverse(nodes.begin(), nodes.end());
+        }
+        topology.push_back(xdmf_polygon);
+        topology.push_back(nodes.size());
+        topology.insert(topology.end(), nodes.begin(), nodes.end());
+    }
+
+    /// Appends cell c of a 3D grid as an XDMF polyhedron: the code, the
+    /// face count, and the node count and nodes of each face.
+    void appendPolyhedron(const UnstructuredGrid& grid, const int c, std::vector<int>& topology)
+    {
+        topology.push_back(xdmf_polyhedron);
+        topology.push_back(grid.cell_facepos[c + 1] - grid.cell_facepos[c]);
+        for (int i = grid.cell_facepos[c]; i < grid.cell_facepos[c + 1]; ++i) {
+            const int f = grid.cell_faces[i];
+            topology.push_back(grid.face_nodepos[f + 1] - grid.face_nodepos[f]);
+            topology.insert(topology.end(), grid.face_nodes + grid.face_nodepos[f],
+                            grid.face_nodes + grid.face_nodepos[f + 1]);
+        }
+    }
+
+    /// Escapes text for use in XML attributes.
+    std::string xmlEscape(const std::string& text)
+    {
+        std::string escaped;
+        for (size_t i = 0; i < text.size(); ++i) {
+            switch (text[i]) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += text[i];
+            }
+        }
+        return escaped;
+    }
+} // anonymous namespace
+
+
+
+OutputWriter::OutputWriter(const Opm::ParameterGroup& param, const UnstructuredGrid& grid)
+    : param_(param),
+      every_(param.getDefault("output_every", 1)),
+      time_interval_(param.getDefault("output_time_interval", 0.0)),
+      format_(Ascii),
+      container_per_tag_(true),
+      grid_(&grid),
+      grid_coordinate_count_(0),
+      grid_topology_count_(0),
+      async_(param.getDefault("output_async", false)),
+      queue_limit_(param.getDefault("output_queue_size", 4)),
+      writing_(false),
+      stop_(false)
+{
+    std::istringstream tags(param.getDefault<std::string>("output_tags", ""));
+    std::string tag;
+    while (std::getline(tags, tag, ',')) {
+        const std::size_t begin = tag.find_first_not_of(" \t");
+        if (begin != std::string::npos) {
+            tags_.insert(tag.substr(begin, tag.find_last_not_of(" \t") + 1 - begin));
+        }
+    }
+    if (every_ < 1) {
+        OPM_THROW(std::runtime_error, "output_every must be positive.");
+    }
+    const std::string format = param.getDefault<std::string>("output_format", "ascii");
+    if (format == "binary") {
+        format_ = Binary;
+    } else if (format == "compressed") {
+#ifdef EQUELLE_HAVE_ZLIB
+        format_ = Compressed;
+#else
+        OPM_THROW(std::runtime_error, "output_format compressed requires a runtime built with zlib.");
+#endif
+    } else if (format == "xdmf") {
+        format_ = Xdmf;
+        if (grid.dimensions != 2 && grid.dimensions != 3) {
+            OPM_THROW(std::runtime_error, "output_format xdmf requires a 2D or 3D grid.");
+        }
+    } else if (format != "ascii") {
+        OPM_THROW(std::runtime_error, "Illegal input " << format
+                  << " for output_format, use ascii, binary, compressed or xdmf.");
+    }
+    const std::string container = param.getDefault<std::string>("output_container", "tag");
+    if (container == "run") {
+        container_per_tag_ = false;
+    } else if (container != "tag") {
+        OPM_THROW(std::runtime_error, "Illegal input " << container
+                  << " for output_container, use tag or run.");
+    }
+    if (async_) {
+        if (queue_limit_ < 1) {
+            OPM_THROW(std::runtime_error, "output_queue_size must be positive.");
+        }
+        writer_ = std::thread(&OutputWriter::writerLoop, this);
+    }
+}
+
+
+OutputWriter::~OutputWriter()
+{
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        queue_changed_.notify_all();
+        writer_.join();
+    }
+    try {
+        flushFiles();
+    } catch (...) {
+        // Errors are lost, see the declaration.
+    }
+}
+
+
+int OutputWriter::nextStep(const std::string& tag)
+{
+    auto it = selection_.find(tag);
+    if (it == selection_.end()) {
+        TagSelection sel;
+        sel.calls = 0;
+        sel.every = param_.getDefault("output_every_" + tag, every_);
+        sel.listed = tags_.empty() || tags_.count(tag) > 0;
+        sel.written = false;
+        if (sel.every < 1) {
+            OPM_THROW(std::runtime_error, "output_every_" << tag << " must be positive.");
+        }
+        it = selection_.insert(std::make_pair(tag, sel)).first;
+    }
+    TagSelection& sel = it->second;
+    const int step = sel.calls++;
+    if (!sel.listed || step % sel.every != 0) {
+        return -1;
+    }
+    if (time_interval_ > 0.0) {
+        const auto now = std::chrono::steady_clock::now();
+        if (sel.written && std::chrono::duration<double>(now - sel.last_written).count() < time_interval_) {
+            return -1;
+        }
+        sel.last_written = now;
+    }
+    sel.written = true;
+    return step;
+}
+
+
+void OutputWriter::write(const std::string& tag, const int step, const double* values, const int n)
+{
+    if (!async_) {
+        writeRecord(tag, step, values, n);
+        return;
+    }
+    Record record = { tag, step, std::vector<double>(values, values + n) };
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Back-pressure: the simulation waits while the queue is full.
+    queue_changed_.wait(lock, [this]() { return int(queue_.size()) < queue_limit_ || writer_error_; });
+    rethrowWriterError();
+    queue_.push_back(std::move(record));
+    lock.unlock();
+    queue_changed_.notify_all();
+}
+
+
+void OutputWriter::flush()
+{
+    if (async_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_changed_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+        rethrowWriterError();
+    }
+    flushFiles();
+}
+
+
+void OutputWriter::setGrid(const UnstructuredGrid& grid)
+{
+    if (grid_coordinate_count_ != 0 || !cell_fields_.empty()) {
+        OPM_THROW(std::runtime_error, "The output grid must be set before the first output.");
+    }
+    grid_ = &grid;
+}
+
+
+void OutputWriter::writeRecord(const std::string& tag, const int step, const double* values, const int n)
+{
+    if (format_ == Ascii) {
+        writeAscii(tag, step, values, n);
+        return;
+    }
+
+    const char* data = reinterpret_cast<const char*>(values);
+    std::uint64_t stored_bytes = n * sizeof(double);
+#ifdef EQUELLE_HAVE_ZLIB
+    if (format_ == Compressed) {
+        uLongf size = compressBound(stored_bytes);
+        deflated_.resize(size);
+        if (compress2(&deflated_[0], &size, reinterpret_cast<const Bytef*>(values),
+                      stored_bytes, Z_BEST_SPEED) != Z_OK) {
+            OPM_THROW(std::runtime_error, "Failed to compress output " << tag);
+        }
+        data = reinterpret_cast<const char*>(&deflated_[0]);
+        stored_bytes = size;
+    }
+#endif
+
+    if (format_ == Xdmf && grid_topology_count_ == 0) {
+        writeGrid();
+    }
+    Container& c = container(tag);
+    RecordHeader header;
+    header.step = step;
+    header.tag_length = tag.size();
+    header.count = n;
+    header.stored_bytes = stored_bytes;
+    const char padding[8] = { 0 };
+    c.index << tag << ' ' << step << ' ' << c.offset << ' ' << n << '\n';
+    c.file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    c.file.write(tag.data(), tag.size());
+    c.file.write(padding, tagPadding(tag.size()));
+    c.file.write(data, stored_bytes);
+    if (!c.file || !c.index) {
+        OPM_THROW(std::runtime_error, "Failed to write output " << tag);
+    }
+    c.offset += sizeof(header) + tag.size() + tagPadding(tag.size());
+    if (format_ == Xdmf && n == grid_->number_of_cells) {
+        const CellField field = { tag, step, c.name, c.offset };
+        cell_fields_.push_back(field);
+    }
+    c.offset += stored_bytes;
+}
+
+
+void OutputWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        queue_changed_.wait(lock, [this]() { return !queue_.empty() || stop_; });
+        if (queue_.empty()) {
+            return; // Stopped, and everything is written.
+        }
+        const Record record = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+        const bool failed = bool(writer_error_);
+        lock.unlock();
+        queue_changed_.notify_all();
+        std::exception_ptr error;
+        if (!failed) {
+            // Records are dropped until the error has been rethrown.
+            try {
+                writeRecord(record.tag, record.step, record.values.data(), record.values.size());
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        lock.lock();
+        writing_ = false;
+        if (error) {
+            writer_error_ = error;
+        }
+        queue_changed_.notify_all();
+    }
+}
+
+
+void OutputWriter::rethrowWriterError()
+{
+    if (writer_error_) {
+        std::exception_ptr error = writer_error_;
+        writer_error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+
+void OutputWriter::flushFiles()
+{
+    for (auto it = containers_.begin(); it != containers_.end(); ++it) {
+        it->second->file.flush();
+        it->second->index.flush();
+    }
+    if (!cell_fields_.empty()) {
+        writeXdmf();
+    }
+}
+
+
+void OutputWriter::writeGrid()
+{
+    const int dim = grid_->dimensions;
+    std::vector<double> coordinates(3 * grid_->number_of_nodes, 0.0);
+    for (int n = 0; n < grid_->number_of_nodes; ++n) {
+        for (int d = 0; d < dim; ++d) {
+            coordinates[3 * n + d] = grid_->node_coordinates[dim * n + d];
+        }
+    }
+    std::vector<int> topology;
+    for (int c = 0; c < grid_->number_of_cells; ++c) {
+        if (dim == 2) {
+            appendPolygon(*grid_, c, topology);
+        } else {
+            appendPolyhedron(*grid_, c, topology);
+        }
+    }
+    std::ofstream file("grid.bin", std::ios::binary);
+    file.write(reinterpret_cast<const char*>(coordinates.data()), coordinates.size() * sizeof(double));
+    file.write(reinterpret_cast<const char*>(topology.data()), topology.size() * sizeof(int));
+    if (!file) {
+        OPM_THROW(std::runtime_error, "Failed to write grid.bin");
+    }
+    grid_coordinate_count_ = coordinates.size();
+    grid_topology_count_ = topology.size();
+}
+
+
+void OutputWriter::writeXdmf() const
+{
+    std::map<int, std::vector<const CellField*> > steps;
+    for (size_t i = 0; i < cell_fields_.size(); ++i) {
+        steps[cell_fields_[i].step].push_back(&cell_fields_[i]);
+    }
+    std::ofstream xmf("output.xmf");
+    if (!xmf) {
+        OPM_THROW(std::runtime_error, "Failed to open output.xmf");
+    }
+    // The grid is repeated by reference only, every step reads the same
+    // part of grid.bin.
+    xmf << "<?xml version=\"1.0\" ?>\n"
+        << "<Xdmf Version=\"3.0\">\n"
+        << "  <Domain>\n"
+        << "    <Grid Name=\"output\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+    for (auto it = steps.begin(); it != steps.end(); ++it) {
+        xmf << "      <Grid Name=\"step " << it->first << "\" GridType=\"Uniform\">\n"
+            << "        <Time Value=\"" << it->first << "\"/>\n"
+            << "        <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << grid_->number_of_cells << "\">\n"
+            << "          <DataItem Dimensions=\"" << grid_topology_count_
+            << "\" NumberType=\"Int\" Precision=\"4\" Format=\"Binary\" Endian=\"Native\" Seek=\""
+            << grid_coordinate_count_ * sizeof(double) << "\">grid.bin</DataItem>\n"
+            << "        </Topology>\n"
+            << "        <Geometry GeometryType=\"XYZ\">\n"
+            << "          <DataItem Dimensions=\"" << grid_->number_of_nodes
+            << " 3\" NumberType=\"Float\" Precision=\"8\" Format=\"Binary\" Endian=\"Native\">grid.bin</DataItem>\n"
+            << "        </Geometry>\n";
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            const CellField& field = *it->second[i];
+            xmf << "        <Attribute Name=\"" << xmlEscape(field.tag) << "\" AttributeType=\"Scalar\" Center=\"Cell\">\n"
+                << "          <DataItem Dimensions=\"" << grid_->number_of_cells
+                << "\" NumberType=\"Float\" Precision=\"8\" Format=\"Binary\" Endian=\"Native\" Seek=\""
+                << field.seek << "\">" << xmlEscape(field.container) << "</DataItem>\n"
+                << "        </Attribute>\n";
+        }
+        xmf << "      </Grid>\n";
+    }
+    xmf << "    </Grid>\n"
+        << "  </Domain>\n"
+        << "</Xdmf>\n";
+    if (!xmf) {
+        OPM_THROW(std::runtime_error, "Failed to write output.xmf");
+    }
+}
+
+
+void OutputWriter::writeAscii(const std::string& tag, const int step,
+                              const double* values, const int n) const
+{
+    std::ostringstream fname;
+    fname << tag << "-" << std::setw(5) << std::setfill('0') << step << ".output";
+    std::ofstream file(fname.str().c_str());
+    if (!file) {
+        OPM_THROW(std::runtime_error, "Failed to open " << fname.str());
+    }
+    file.precision(16);
+    std::copy(values, values + n, std::ostream_iterator<double>(file, "\n"));
+}
+
+
+OutputWriter::Container& OutputWriter::container(const std::string& tag)
+{
+    const std::string name = container_per_tag_ ? tag + ".eqo" : "output.eqo";
+    std::unique_ptr<Container>& c = containers_[name];
+    if (c) {
+        return *c;
+    }
+    c.reset(new Container);
+    c->name = name;
+    // The buffers must be installed before the files are opened.
+    c->file_buffer.resize(container_buffer_bytes);
+    c->file.rdbuf()->pubsetbuf(&c->file_buffer[0], c->file_buffer.size());
+    c->file.open(name.c_str(), std::ios::binary);
+    c->index_buffer.resize(container_buffer_bytes / 64);
+    c->index.rdbuf()->pubsetbuf(&c->index_buffer[0], c->index_buffer.size());
+    c->index.open((name + ".index").c_str());
+    if (!c->file || !c->index) {
+        OPM_THROW(std::runtime_error, "Failed to open " << name);
+    }
+    const std::uint32_t compression = format_ == Compressed ? 1 : 0;
+    c->file.write(container_magic, sizeof(container_magic));
+    c->file.write(reinterpret_cast<const char*>(&container_version), sizeof(container_version));
+    c->file.write(reinterpret_cast<const char*>(&compression), sizeof(compression));
+    c->offset = sizeof(container_magic) + sizeof(container_version) + sizeof(compression);
+    return *c;
+}
+
+
+} // namespace equelle
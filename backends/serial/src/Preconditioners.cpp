@@ -0,0 +1,438 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/Preconditioners.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace equelle {
+
+namespace
+{
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> DenseBlock;
+
+    /// inv = a^{-1} for a row major bs x bs block. Returns false if a
+    /// is singular.
+    bool invertBlock(const double* a, double* inv, const int bs)
+    {
+        Eigen::Map<const DenseBlock> am(a, bs, bs);
+        Eigen::Map<DenseBlock> invm(inv, bs, bs);
+        invm = am.inverse();
+        return invm.allFinite();
+    }
+
+    /// c = a b for bs x bs blocks.
+    void multiplyBlocks(const double* a, const double* b, double* c, const int bs)
+    {
+        for (int i = 0; i < bs; ++i) {
+            for (int j = 0; j < bs; ++j) {
+                double sum = 0.0;
+                for (int k = 0; k < bs; ++k) {
+                    sum += a[i*bs + k] * b[k*bs + j];
+                }
+                c[i*bs + j] = sum;
+            }
+        }
+    }
+
+    /// c -= a b for bs x bs blocks.
+    void subtractProduct(const double* a, const double* b, double* c, const int bs)
+    {
+        for (int i = 0; i < bs; ++i) {
+            for (int j = 0; j < bs; ++j) {
+                double sum = 0.0;
+                for (int k = 0; k < bs; ++k) {
+                    sum += a[i*bs + k] * b[k*bs + j];
+                }
+                c[i*bs + j] -= sum;
+            }
+        }
+    }
+
+    /// y -= a x for a bs x bs block a.
+    void subtractBlockTimesVector(const double* a, const double* x, double* y, const int bs)
+    {
+        for (int i = 0; i < bs; ++i) {
+            for (int j = 0; j < bs; ++j) {
+                y[i] -= a[i*bs + j] * x[j];
+            }
+        }
+    }
+
+    /// y = a x for a bs x bs block a.
+    void blockTimesVector(const double* a, const double* x, double* y, const int bs)
+    {
+        for (int i = 0; i < bs; ++i) {
+            y[i] = 0.0;
+            for (int j = 0; j < bs; ++j) {
+                y[i] += a[i*bs + j] * x[j];
+            }
+        }
+    }
+
+    /// Frobenius norm of a bs x bs block.
+    double blockNorm(const double* a, const int bs)
+    {
+        return Eigen::Map<const Eigen::VectorXd>(a, bs*bs).norm();
+    }
+
+    // Parameters of the AMG hierarchy.
+    const double amg_strength_threshold = 0.08;
+    const double amg_jacobi_damping = 2.0 / 3.0;
+    const int amg_max_levels = 10;
+    const int amg_coarse_rows = 100;
+    const int amg_max_direct_size = 2000;
+
+    /// Aggregates the block rows of a, returning the aggregate of each
+    /// block row and setting num_aggregates. Block f is a strong neighbour
+    /// of row e if |a_ef| >= threshold sqrt(|a_ee| |a_ff|).
+    std::vector<int> aggregateRows(const BlockCsrMatrix& a, int& num_aggregates)
+    {
+        const int n = a.blockRows();
+        const int bs = a.blockSize();
+        const int bs2 = bs * bs;
+        const std::vector<int>& row_start = a.rowStart();
+        const std::vector<int>& col = a.colIndex();
+        const std::vector<int>& diag = a.diagonal();
+        const std::vector<double>& val = a.values();
+        std::vector<double> diag_norm(n);
+        for (int e = 0; e < n; ++e) {
+            diag_norm[e] = blockNorm(&val[diag[e]*bs2], bs);
+        }
+        std::vector<char> strong(col.size(), 0);
+        for (int e = 0; e < n; ++e) {
+            for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+                const int f = col[b];
+                strong[b] = f != e && blockNorm(&val[b*bs2], bs)
+                    >= amg_strength_threshold * std::sqrt(diag_norm[e] * diag_norm[f]);
+            }
+        }
+        std::vector<int> agg(n, -1);
+        num_aggregates = 0;
+        // First pass: rows whose strong neighbours are all free seed
+        // an aggregate of the row and those neighbours.
+        for (int e = 0; e < n; ++e) {
+            if (agg[e] >= 0) {
+                continue;
+            }
+            bool free = true;
+            for (int b = row_start[e]; b < row_start[e + 1] && free; ++b) {
+                free = !strong[b] || agg[col[b]] < 0;
+            }
+            if (!free) {
+                continue;
+            }
+            agg[e] = num_aggregates;
+            for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+                if (strong[b]) {
+                    agg[col[b]] = num_aggregates;
+                }
+            }
+            ++num_aggregates;
+        }
+        // Second pass: remaining rows join the aggregate of a strong
+        // neighbour, or make their own.
+        const std::vector<int> first = agg;
+        for (int e = 0; e < n; ++e) {
+            if (agg[e] >= 0) {
+                continue;
+            }
+            for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+                if (strong[b] && first[col[b]] >= 0) {
+                    agg[e] = first[col[b]];
+                    break;
+                }
+            }
+            if (agg[e] < 0) {
+                agg[e] = num_aggregates++;
+            }
+        }
+        return agg;
+    }
+
+    /// Sets coarse to the Galerkin product P^T a P, where P maps the
+    /// coarse block row agg[e] to the block row e.
+    void galerkinProduct(const BlockCsrMatrix& a, const std::vector<int>& agg,
+                         const int num_aggregates, BlockCsrMatrix& coarse)
+    {
+        const int n = a.blockRows();
+        const int bs = a.blockSize();
+        const int bs2 = bs * bs;
+        const std::vector<int>& row_start = a.rowStart();
+        const std::vector<int>& col = a.colIndex();
+        const std::vector<double>& val = a.values();
+        std::vector<std::vector<int> > members(num_aggregates);
+        for (int e = 0; e < n; ++e) {
+            members[agg[e]].push_back(e);
+        }
+        std::vector<int> crow_start(num_aggregates + 1, 0);
+        std::vector<int> ccol;
+        for (int c = 0; c < num_aggregates; ++c) {
+            std::vector<int> cols;
+            for (size_t m = 0; m < members[c].size(); ++m) {
+                const int e = members[c][m];
+                for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+                    cols.push_back(agg[col[b]]);
+                }
+            }
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+            ccol.insert(ccol.end(), cols.begin(), cols.end());
+            crow_start[c + 1] = ccol.size();
+        }
+        std::vector<double> cval(ccol.size() * bs2, 0.0);
+        for (int c = 0; c < num_aggregates; ++c) {
+            const std::vector<int>::const_iterator begin = ccol.begin() + crow_start[c];
+            const std::vector<int>::const_iterator end = ccol.begin() + crow_start[c + 1];
+            for (size_t m = 0; m < members[c].size(); ++m) {
+                const int e = members[c][m];
+                for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+                    const int pos = std::lower_bound(begin, end, agg[col[b]]) - ccol.begin();
+                    for (int k = 0; k < bs2; ++k) {
+                        cval[pos*bs2 + k] += val[b*bs2 + k];
+                    }
+                }
+            }
+        }
+        coarse.setBlocks(bs, crow_start, ccol, cval);
+    }
+} // anonymous namespace
+
+
+
+void IdentityPreconditioner::setup(const BlockCsrMatrix& a)
+{
+    size_ = a.blockRows() * a.blockSize();
+}
+
+
+void IdentityPreconditioner::apply(const double* r, double* z) const
+{
+    std::copy(r, r + size_, z);
+}
+
+
+
+
+void BlockJacobiPreconditioner::setup(const BlockCsrMatrix& a)
+{
+    block_size_ = a.blockSize();
+    block_rows_ = a.blockRows();
+    const int bs2 = block_size_ * block_size_;
+    inv_diag_.resize(block_rows_ * bs2);
+    bool ok = true;
+#pragma omp parallel for reduction(&&:ok)
+    for (int e = 0; e < block_rows_; ++e) {
+        ok = invertBlock(&a.values()[a.diagonal()[e] * bs2], &inv_diag_[e * bs2], block_size_) && ok;
+    }
+    if (!ok) {
+        OPM_THROW(std::runtime_error, "Singular diagonal block in preconditioner setup.");
+    }
+}
+
+
+void BlockJacobiPreconditioner::apply(const double* r, double* z) const
+{
+    const int bs = block_size_;
+#pragma omp parallel for
+    for (int e = 0; e < block_rows_; ++e) {
+        blockTimesVector(&inv_diag_[e*bs*bs], r + e*bs, z + e*bs, bs);
+    }
+}
+
+
+
+void BlockILU0Preconditioner::setup(const BlockCsrMatrix& a)
+{
+    a_ = &a;
+    const int n = a.blockRows();
+    const int bs = a.blockSize();
+    const int bs2 = bs * bs;
+    const std::vector<int>& row_start = a.rowStart();
+    const std::vector<int>& col = a.colIndex();
+    const std::vector<int>& diag = a.diagonal();
+    lu_ = a.values();
+    inv_diag_.resize(n * bs2);
+    std::vector<double> l(bs2);
+    // Position of each block column in the current row, or -1.
+    std::vector<int> marker(n, -1);
+    for (int e = 0; e < n; ++e) {
+        for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+            marker[col[b]] = b;
+        }
+        for (int b = row_start[e]; b < diag[e]; ++b) {
+            const int k = col[b];
+            // L_ek = A_ek U_kk^{-1}
+            multiplyBlocks(&lu_[b*bs2], &inv_diag_[k*bs2], l.data(), bs);
+            std::copy(l.begin(), l.end(), &lu_[b*bs2]);
+            // A_ej -= L_ek U_kj, for the j > k in the pattern of row e.
+            for (int bb = diag[k] + 1; bb < row_start[k + 1]; ++bb) {
+                const int pos = marker[col[bb]];
+                if (pos >= 0) {
+                    subtractProduct(&lu_[b*bs2], &lu_[bb*bs2], &lu_[pos*bs2], bs);
+                }
+            }
+        }
+        if (!invertBlock(&lu_[diag[e]*bs2], &inv_diag_[e*bs2], bs)) {
+            OPM_THROW(std::runtime_error, "Singular diagonal block in preconditioner setup.");
+        }
+        for (int b = row_start[e]; b < row_start[e + 1]; ++b) {
+            marker[col[b]] = -1;
+        }
+    }
+}
+
+
+void BlockILU0Preconditioner::apply(const double* r, double* z) const
+{
+    const int n = a_->blockRows();
+    const int bs = a_->blockSize();
+    const int bs2 = bs * bs;
+    const std::vector<int>& row_start = a_->rowStart();
+    const std::vector<int>& col = a_->colIndex();
+    const std::vector<int>& diag = a_->diagonal();
+    // Forward substitution with L, which has unit diagonal blocks.
+    std::copy(r, r + n*bs, z);
+    for (int e = 0; e < n; ++e) {
+        for (int b = row_start[e]; b < diag[e]; ++b) {
+            subtractBlockTimesVector(&lu_[b*bs2], z + col[b]*bs, z + e*bs, bs);
+        }
+    }
+    // Backward substitution with U.
+    std::vector<double> y(bs);
+    for (int e = n - 1; e >= 0; --e) {
+        for (int b = diag[e] + 1; b < row_start[e + 1]; ++b) {
+            subtractBlockTimesVector(&lu_[b*bs2], z + col[b]*bs, z + e*bs, bs);
+        }
+        std::copy(z + e*bs, z + (e + 1)*bs, y.begin());
+        blockTimesVector(&inv_diag_[e*bs2], y.data(), z + e*bs, bs);
+    }
+}
+
+
+
+void AMGPreconditioner::setup(const BlockCsrMatrix& a)
+{
+    a_.assign(1, &a);
+    aggregate_.clear();
+    coarse_.clear();
+    // Reserved so that the pointers in a_ stay valid.
+    coarse_.reserve(amg_max_levels);
+    while (int(a_.size()) < amg_max_levels && a_.back()->blockRows() > amg_coarse_rows) {
+        const BlockCsrMatrix& fine = *a_.back();
+        int num_aggregates = 0;
+        std::vector<int> agg = aggregateRows(fine, num_aggregates);
+        if (num_aggregates >= fine.blockRows()) {
+            break; // No coarsening.
+        }
+        coarse_.push_back(BlockCsrMatrix());
+        galerkinProduct(fine, agg, num_aggregates, coarse_.back());
+        aggregate_.push_back(std::vector<int>());
+        aggregate_.back().swap(agg);
+        a_.push_back(&coarse_.back());
+    }
+    const int levels = a_.size();
+    smoother_.resize(levels);
+    x_.resize(levels);
+    b_.resize(levels);
+    r_.resize(levels);
+    t_.resize(levels);
+    for (int l = 0; l < levels; ++l) {
+        smoother_[l].setup(*a_[l]);
+        const int size = a_[l]->blockRows() * a_[l]->blockSize();
+        x_[l].resize(size);
+        b_[l].resize(size);
+        r_[l].resize(size);
+        t_[l].resize(size);
+    }
+
+    // Dense coarsest matrix, in block order.
+    const BlockCsrMatrix& c = *a_.back();
+    const int bs = c.blockSize();
+    const int size = c.blockRows() * bs;
+    direct_coarse_ = size <= amg_max_direct_size;
+    if (direct_coarse_) {
+        Eigen::MatrixXd dense = Eigen::MatrixXd::Zero(size, size);
+        for (int e = 0; e < c.blockRows(); ++e) {
+            for (int b = c.rowStart()[e]; b < c.rowStart()[e + 1]; ++b) {
+                const int f = c.colIndex()[b];
+                for (int i = 0; i < bs; ++i) {
+                    for (int j = 0; j < bs; ++j) {
+                        dense(e*bs + i, f*bs + j) = c.values()[(b*bs + i)*bs + j];
+                    }
+                }
+            }
+        }
+        coarse_lu_.compute(dense);
+    }
+}
+
+
+void AMGPreconditioner::apply(const double* r, double* z) const
+{
+    b_[0] = Eigen::Map<const Eigen::VectorXd>(r, b_[0].size());
+    cycle(0);
+    Eigen::Map<Eigen::VectorXd>(z, x_[0].size()) = x_[0];
+}
+
+
+int AMGPreconditioner::levels() const
+{
+    return a_.size();
+}
+
+
+void AMGPreconditioner::cycle(const int level) const
+{
+    const BlockCsrMatrix& a = *a_[level];
+    Eigen::VectorXd& x = x_[level];
+    const Eigen::VectorXd& b = b_[level];
+    Eigen::VectorXd& r = r_[level];
+    Eigen::VectorXd& t = t_[level];
+    const bool coarsest = level + 1 == int(a_.size());
+    if (coarsest && direct_coarse_) {
+        x = coarse_lu_.solve(b);
+        return;
+    }
+
+    // Pre-smoothing, from a zero initial guess.
+    smoother_[level].apply(b.data(), t.data());
+    x = amg_jacobi_damping * t;
+    if (!coarsest) {
+        // Restriction of the residual.
+        a.multiply(x.data(), r.data());
+        r = b - r;
+        const int bs = a.blockSize();
+        const std::vector<int>& agg = aggregate_[level];
+        Eigen::VectorXd& bc = b_[level + 1];
+        bc.setZero();
+        for (int e = 0; e < a.blockRows(); ++e) {
+            for (int i = 0; i < bs; ++i) {
+                bc[agg[e]*bs + i] += r[e*bs + i];
+            }
+        }
+        cycle(level + 1);
+        // Prolongation of the coarse correction.
+        const Eigen::VectorXd& xc = x_[level + 1];
+        for (int e = 0; e < a.blockRows(); ++e) {
+            for (int i = 0; i < bs; ++i) {
+                x[e*bs + i] += xc[agg[e]*bs + i];
+            }
+        }
+    }
+
+    // Post-smoothing.
+    a.multiply(x.data(), r.data());
+    r = b - r;
+    smoother_[level].apply(r.data(), t.data());
+    x += amg_jacobi_damping * t;
+}
+
+
+} // namespace equelle
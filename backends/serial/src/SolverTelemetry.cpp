@@ -0,0 +1,126 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+
+#include "equelle/SolverTelemetry.hpp"
+#include <opm/common/ErrorMacros.hpp>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+
+namespace equelle {
+
+namespace
+{
+    /// Writes x as a JSON number, or null if it is not finite.
+    void writeJsonNumber(std::ostream& os, const double x)
+    {
+        if (std::isfinite(x)) {
+            os << x;
+        } else {
+            os << "null";
+        }
+    }
+} // anonymous namespace
+
+
+
+int NewtonSolveRecord::newtonIterations() const
+{
+    return iterations.empty() ? 0 : iterations.size() - 1;
+}
+
+
+int NewtonSolveRecord::linearIterations() const
+{
+    int sum = 0;
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        sum += iterations[i].linear_iterations;
+    }
+    return sum;
+}
+
+
+
+void SolverTelemetry::add(const NewtonSolveRecord& record)
+{
+    records_.push_back(record);
+}
+
+
+const std::vector<NewtonSolveRecord>& SolverTelemetry::records() const
+{
+    return records_;
+}
+
+
+void SolverTelemetry::writeCsv(std::ostream& os) const
+{
+    os << std::setprecision(10);
+    os << "solve,site,converged,iteration,residual_norm,linear_iterations,"
+       << "assembly_time,solve_time,setup_time\n";
+    for (size_t s = 0; s < records_.size(); ++s) {
+        const NewtonSolveRecord& rec = records_[s];
+        for (size_t i = 0; i < rec.iterations.size(); ++i) {
+            const NewtonIterationRecord& it = rec.iterations[i];
+            os << s << ',' << rec.site << ',' << (rec.converged ? 1 : 0) << ',' << i << ','
+               << it.residual_norm << ',' << it.linear_iterations << ','
+               << it.assembly_time << ',' << it.solve_time << ',' << it.setup_time << '\n';
+        }
+    }
+}
+
+
+void SolverTelemetry::writeJson(std::ostream& os) const
+{
+    os << std::setprecision(10);
+    os << "[";
+    for (size_t s = 0; s < records_.size(); ++s) {
+        const NewtonSolveRecord& rec = records_[s];
+        os << (s == 0 ? "\n" : ",\n")
+           << "  {\"solve\": " << s
+           << ", \"site\": " << rec.site
+           << ", \"converged\": " << (rec.converged ? "true" : "false")
+           << ", \"newton_iterations\": " << rec.newtonIterations()
+           << ", \"linear_iterations\": " << rec.linearIterations()
+           << ", \"time\": ";
+        writeJsonNumber(os, rec.time);
+        os << ",\n   \"iterations\": [";
+        for (size_t i = 0; i < rec.iterations.size(); ++i) {
+            const NewtonIterationRecord& it = rec.iterations[i];
+            os << (i == 0 ? "\n" : ",\n") << "    {\"residual_norm\": ";
+            writeJsonNumber(os, it.residual_norm);
+            os << ", \"linear_iterations\": " << it.linear_iterations << ", \"assembly_time\": ";
+            writeJsonNumber(os, it.assembly_time);
+            os << ", \"solve_time\": ";
+            writeJsonNumber(os, it.solve_time);
+            os << ", \"setup_time\": ";
+            writeJsonNumber(os, it.setup_time);
+            os << "}";
+        }
+        os << "]}";
+    }
+    os << "\n]\n";
+}
+
+
+void SolverTelemetry::write(const std::string& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if (!file) {
+        OPM_THROW(std::runtime_error, "Failed to open " << filename);
+    }
+    const std::string csv = ".csv";
+    if (filename.size() >= csv.size()
+        && filename.compare(filename.size() - csv.size(), csv.size(), csv) == 0) {
+        writeCsv(file);
+    } else {
+        writeJson(file);
+    }
+}
+
+
+} // namespace equelle
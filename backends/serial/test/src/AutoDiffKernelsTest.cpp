@@ -0,0 +1,172 @@
+#define BOOST_TEST_NO_MAIN
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/grid/GridManager.hpp>
+
+#include "equelle/AutoDiffKernels.hpp"
+#include "equelle/EquelleRuntimeCPU.hpp"
+
+using namespace equelle;
+
+namespace
+{
+    typedef CollOfScalar::ADB ADB;
+
+    Eigen::MatrixXd dense(const CollOfScalar::M& m)
+    {
+        SparseColMajor s;
+        m.toSparse(s);
+        return Eigen::MatrixXd(s);
+    }
+
+    /// Checks that the entries of each column are sorted by row, with no
+    /// row repeated, as the AutoDiffBlock jacobians require.
+    void checkStrictlySorted(const CollOfScalar::M& m)
+    {
+        SparseColMajor s;
+        m.toSparse(s);
+        s.makeCompressed();
+        for (int c = 0; c < s.cols(); ++c) {
+            for (int k = s.outerIndexPtr()[c] + 1; k < s.outerIndexPtr()[c + 1]; ++k) {
+                BOOST_CHECK_LT(s.innerIndexPtr()[k - 1], s.innerIndexPtr()[k]);
+            }
+        }
+    }
+
+    /// Compares the values and every jacobian block of a kernel result
+    /// with the reference computed with sparse matrix products.
+    void checkSame(const ADB& result, const ADB& expected)
+    {
+        BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+        for (int i = 0; i < result.size(); ++i) {
+            BOOST_CHECK_SMALL(result.value()[i] - expected.value()[i], 1e-12);
+        }
+        BOOST_REQUIRE_EQUAL(result.derivative().size(), expected.derivative().size());
+        for (std::size_t b = 0; b < result.derivative().size(); ++b) {
+            checkStrictlySorted(result.derivative()[b]);
+            const Eigen::MatrixXd r = dense(result.derivative()[b]);
+            const Eigen::MatrixXd e = dense(expected.derivative()[b]);
+            BOOST_REQUIRE_EQUAL(r.rows(), e.rows());
+            BOOST_REQUIRE_EQUAL(r.cols(), e.cols());
+            BOOST_CHECK_SMALL((r - e).cwiseAbs().maxCoeff(), 1e-12);
+        }
+    }
+
+    /// Two primary variables of size n, with distinct values.
+    std::vector<ADB> unknowns(const int n)
+    {
+        std::vector<CollOfScalar::V> values(2, CollOfScalar::V(n));
+        for (int i = 0; i < n; ++i) {
+            values[0][i] = 1.0 + 0.5 * i;
+            values[1][i] = 2.0 - 0.25 * i * i;
+        }
+        return ADB::variables(values);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( stencilUnsortedAndRepeatedTargets ) {
+    // Row 0 hits targets 3, 0, 3; row 1 targets 2, 1, 0, 2; row 2 none;
+    // row 3 target 1.
+    RowStencil st;
+    st.rows = 4;
+    const int start[] = { 0, 3, 7, 7, 8 };
+    const int target[] = { 3, 0, 3, 2, 1, 0, 2, 1 };
+    const double weight[] = { 1.0, -2.0, 0.5, 3.0, -1.0, 1.5, -0.25, 2.0 };
+    st.start.assign(start, start + 5);
+    st.target.assign(target, target + 8);
+    st.weight.assign(weight, weight + 8);
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (int r = 0; r < 4; ++r) {
+        for (int k = st.start[r]; k < st.start[r + 1]; ++k) {
+            triplets.emplace_back(st.target[k], r, st.weight[k]);
+        }
+    }
+    SparseColMajor s(4, 4);
+    s.setFromTriplets(triplets.begin(), triplets.end());
+    const CollOfScalar::M S(s);
+
+    // Jacobians with several entries per column, in two blocks.
+    const std::vector<ADB> u = unknowns(4);
+    const ADB x = u[0] * u[1] + S * u[0] + u[1] * u[1];
+    checkSame(applyStencil(x, st), S * x);
+
+    // Without jacobians.
+    const ADB c = ADB::constant(x.value());
+    const ADB sc = applyStencil(c, st);
+    BOOST_CHECK(sc.derivative().empty());
+    checkSame(sc, S * c);
+}
+
+
+BOOST_AUTO_TEST_CASE( stencilOperatorsMatchHelperOps ) {
+    Opm::ParameterGroup param;
+    param.insertParameter("grid_dim", "2");
+    param.insertParameter("nx", "3");
+    param.insertParameter("ny", "2");
+    EquelleRuntimeCPU er(param);
+    Opm::GridManager gm(3, 2, 1.0, 1.0);
+    const Opm::HelperOps ops(*gm.c_grid());
+    const int nc = gm.c_grid()->number_of_cells;
+    const int nf = gm.c_grid()->number_of_faces;
+    const int nif = ops.internal_faces.size();
+
+    const std::vector<ADB> u = unknowns(nc);
+    const ADB cells = ops.div * (ops.grad * u[0]) + u[0] * u[1];
+    checkSame(er.gradient(cells), ops.grad * cells);
+    checkSame(er.negGradient(cells), ops.ngrad * cells);
+
+    const ADB interior_fluxes = ops.ngrad * (u[0] * u[1]);
+    BOOST_REQUIRE_EQUAL(interior_fluxes.size(), nif);
+    checkSame(er.interiorDivergence(interior_fluxes), ops.div * interior_fluxes);
+    checkSame(er.divergence(interior_fluxes), ops.div * interior_fluxes);
+
+    const ADB fluxes = ops.fullngrad * (u[0] * u[0] + u[1]);
+    BOOST_REQUIRE_EQUAL(fluxes.size(), nf);
+    checkSame(er.divergence(fluxes), ops.fulldiv * fluxes);
+}
+
+
+BOOST_AUTO_TEST_CASE( productsMatchAutoDiffBlock ) {
+    // Jacobians with different patterns in the two factors, so that the
+    // product has entries from one or both of them.
+    RowStencil st;
+    st.rows = 5;
+    const int start[] = { 0, 2, 3, 3, 5, 6 };
+    const int target[] = { 4, 1, 0, 2, 3, 4 };
+    const double weight[] = { 1.0, -1.0, 2.0, 0.5, 1.5, -3.0 };
+    st.start.assign(start, start + 6);
+    st.target.assign(target, target + 6);
+    st.weight.assign(weight, weight + 6);
+    const std::vector<ADB> u = unknowns(5);
+    const ADB xa = applyStencil(u[0], st) + u[1];
+    const ADB ya = u[0] * u[0] + applyStencil(u[1] * u[0], st);
+    const ADB ca = ADB::constant(xa.value() + 3.0);
+    const CollOfScalar x = xa;
+    const CollOfScalar y = ya;
+    const CollOfScalar c = ca;
+    const CollOfScalarValue v = ca.value();
+
+    // Products of two plain AutoDiffBlocks are the reference.
+    checkSame(x * y, xa * ya);
+    checkSame(x / y, xa / ya);
+    checkSame(xa * y, xa * ya);
+    checkSame(x / ya, xa / ya);
+    checkSame(x * c, xa * ca);
+    checkSame(c * y, ca * ya);
+    checkSame(x / c, xa / ca);
+    checkSame(c / y, ca / ya);
+    checkSame(v * y, ca * ya);
+    checkSame(y / v, ya / ca);
+    checkSame((v * v) * x, ADB::constant(v * v) * xa);
+    checkSame(2.5 * x, ADB::constant(CollOfScalar::V::Constant(5, 2.5)) * xa);
+    checkSame(x / 2.5, xa / ADB::constant(CollOfScalar::V::Constant(5, 2.5)));
+    checkSame(2.5 / y, ADB::constant(CollOfScalar::V::Constant(5, 2.5)) / ya);
+    const CollOfScalar cc = c * c;
+    BOOST_CHECK(cc.derivative().empty());
+}
@@ -0,0 +1,152 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE EquelleSerialBackendTest
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "equelle/FieldFile.hpp"
+
+using namespace equelle;
+
+namespace
+{
+    void writeFile(const std::string& filename, const std::string& contents)
+    {
+        std::ofstream f(filename.c_str(), std::ios::binary);
+        f << contents;
+    }
+
+    /// The whitespace separated tokens of s, parsed with strtod().
+    std::vector<double> strtodTokens(const std::string& s)
+    {
+        std::istringstream is(s);
+        std::vector<double> values;
+        std::string token;
+        while (is >> token) {
+            values.push_back(std::strtod(token.c_str(), nullptr));
+        }
+        return values;
+    }
+
+    /// Compares the bits, so that the sign of zero counts.
+    void checkIdentical(const std::vector<double>& parsed, const std::vector<double>& expected)
+    {
+        BOOST_REQUIRE_EQUAL(parsed.size(), expected.size());
+        for (std::size_t i = 0; i < parsed.size(); ++i) {
+            std::uint64_t a;
+            std::uint64_t b;
+            std::memcpy(&a, &parsed[i], sizeof(a));
+            std::memcpy(&b, &expected[i], sizeof(b));
+            BOOST_CHECK_MESSAGE(a == b, "value " << i << ": " << parsed[i] << " != " << expected[i]);
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( asciiParseMatchesStrtod ) {
+    const std::string contents =
+        "0 -0 1 -1 +2.5 .5 5. 0.1 0.2 0.30000000000000004\n"
+        "3.141592653589793 2.718281828459045e0 1e10 1E-5 -6.02214076e23\n"
+        "9007199254740993 123456789012345678901234567890 0.000001234\n"
+        "1.7976931348623157e308 2.2250738585072014e-308 4.9e-324\t\t\r\n"
+        "1e22 1e23 8.589973e9 1234567890123456789 12345678901234567890\n"
+        "   0.1e-1   -0.0e5 7e-10\n";
+    writeFile("ascii_strtod.txt", contents);
+
+    AsciiFile file("ascii_strtod.txt");
+    BOOST_REQUIRE_EQUAL(file.size(), int(strtodTokens(contents).size()));
+    std::vector<double> parsed(file.size());
+    file.parseTo(parsed.data());
+    checkIdentical(parsed, strtodTokens(contents));
+}
+
+
+BOOST_AUTO_TEST_CASE( asciiChunkBoundaries ) {
+    // Several MB of numbers of varying length, so that the chunk
+    // boundaries fall inside numbers and inside runs of whitespace.
+    std::ostringstream os;
+    std::uint64_t state = 12345;
+    while (os.tellp() < 5 * (1 << 20)) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const double x = double(state >> 11) / double(1ULL << 53) - 0.5;
+        const int precision = 1 + (state >> 3) % 17;
+        const int exponent = int((state >> 8) % 41) - 20;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, x * std::pow(10.0, exponent));
+        os << buf << std::string(1 + (state >> 20) % 3, (state >> 24) % 2 ? ' ' : '\n');
+    }
+    const std::string contents = os.str();
+    writeFile("ascii_chunks.txt", contents);
+
+    AsciiFile file("ascii_chunks.txt");
+    const std::vector<double> expected = strtodTokens(contents);
+    BOOST_REQUIRE_EQUAL(file.size(), int(expected.size()));
+    std::vector<double> parsed(file.size());
+    file.parseTo(parsed.data());
+    checkIdentical(parsed, expected);
+}
+
+
+BOOST_AUTO_TEST_CASE( asciiParseIntegers ) {
+    writeFile("ascii_ints.txt", "0 1 -2 +3\n2147483647 -2147483648\n  42\n");
+    AsciiFile file("ascii_ints.txt");
+    BOOST_REQUIRE_EQUAL(file.size(), 7);
+    std::vector<int> parsed(file.size());
+    file.parseTo(parsed.data());
+    const int expected[] = { 0, 1, -2, 3, 2147483647, -2147483647 - 1, 42 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed.begin(), parsed.end(), expected, expected + 7);
+}
+
+
+BOOST_AUTO_TEST_CASE( asciiParseRejectsBadTokens ) {
+    writeFile("ascii_bad.txt", "1 2 x 4\n");
+    AsciiFile file("ascii_bad.txt");
+    BOOST_REQUIRE_EQUAL(file.size(), 4);
+    std::vector<double> parsed(file.size());
+    BOOST_CHECK_THROW(file.parseTo(parsed.data()), std::runtime_error);
+    std::vector<int> parsed_int(file.size());
+    writeFile("ascii_bad_int.txt", "1 2.5\n");
+    AsciiFile int_file("ascii_bad_int.txt");
+    BOOST_CHECK_THROW(int_file.parseTo(parsed_int.data()), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE( fieldFileRoundTrip ) {
+    const std::vector<double> values = { 0.0, -1.5, 1e300, 4.9e-324, 3.0 };
+    FieldFile::write("field.eqf", values.data(), values.size(), FieldEntity::Faces);
+
+    FieldFile file("field.eqf");
+    BOOST_CHECK_EQUAL(file.size(), int(values.size()));
+    BOOST_CHECK(file.type() == FieldType::Float64);
+    BOOST_CHECK(file.entity() == FieldEntity::Faces);
+    BOOST_CHECK_EQUAL_COLLECTIONS(file.data(), file.data() + file.size(), values.begin(), values.end());
+    std::vector<double> copied(file.size());
+    file.copyTo(copied.data());
+    BOOST_CHECK_EQUAL_COLLECTIONS(copied.begin(), copied.end(), values.begin(), values.end());
+    BOOST_CHECK_EQUAL(file.value(1), -1.5);
+}
+
+
+BOOST_AUTO_TEST_CASE( fieldFileRejectsOtherFiles ) {
+    writeFile("not_a_field.eqf", "0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15\n");
+    BOOST_CHECK_THROW(FieldFile("not_a_field.eqf"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE( binaryInputFormat ) {
+    BOOST_CHECK(isBinaryInput("auto", "perm.eqf"));
+    BOOST_CHECK(!isBinaryInput("auto", "perm.txt"));
+    BOOST_CHECK(isBinaryInput("binary", "perm.txt"));
+    BOOST_CHECK(!isBinaryInput("ascii", "perm.eqf"));
+    BOOST_CHECK_THROW(isBinaryInput("hdf5", "perm.eqf"), std::runtime_error);
+}
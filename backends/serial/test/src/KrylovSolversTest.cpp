@@ -0,0 +1,193 @@
+#define BOOST_TEST_NO_MAIN
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "equelle/KrylovSolvers.hpp"
+
+using namespace equelle;
+
+namespace
+{
+    struct DenseOperator
+    {
+        Eigen::MatrixXd A;
+        void multiply(const double* x, double* y) const
+        {
+            Eigen::Map<Eigen::VectorXd>(y, A.rows()) = A * Eigen::Map<const Eigen::VectorXd>(x, A.cols());
+        }
+    };
+
+    struct NoPreconditioner
+    {
+        int n;
+        void apply(const double* r, double* z) const
+        {
+            std::copy(r, r + n, z);
+        }
+    };
+
+    struct JacobiPreconditioner
+    {
+        Eigen::VectorXd diagonal;
+        void apply(const double* r, double* z) const
+        {
+            Eigen::Map<Eigen::VectorXd>(z, diagonal.size()) = Eigen::Map<const Eigen::VectorXd>(r, diagonal.size()).cwiseQuotient(diagonal);
+        }
+    };
+
+    /// The 1D Laplacian, symmetric positive definite.
+    DenseOperator laplacian(const int n)
+    {
+        DenseOperator op = { Eigen::MatrixXd::Zero(n, n) };
+        for (int i = 0; i < n; ++i) {
+            op.A(i, i) = 2.0 + 0.01 * i;
+            if (i > 0) {
+                op.A(i, i - 1) = -1.0;
+                op.A(i - 1, i) = -1.0;
+            }
+        }
+        return op;
+    }
+
+    /// Upwinded convection-diffusion, nonsymmetric.
+    DenseOperator convectionDiffusion(const int n)
+    {
+        DenseOperator op = { Eigen::MatrixXd::Zero(n, n) };
+        for (int i = 0; i < n; ++i) {
+            op.A(i, i) = 3.0;
+            if (i > 0) {
+                op.A(i, i - 1) = -2.0;
+            }
+            if (i + 1 < n) {
+                op.A(i, i + 1) = -0.5;
+            }
+        }
+        return op;
+    }
+
+    Eigen::VectorXd rightHandSide(const int n)
+    {
+        Eigen::VectorXd b(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = std::sin(0.3 * i) + 1.0;
+        }
+        return b;
+    }
+
+    void checkSolution(const KrylovReport& rep, const DenseOperator& op,
+                       const Eigen::VectorXd& b, const Eigen::VectorXd& x, const double tol)
+    {
+        BOOST_CHECK(rep.converged);
+        BOOST_CHECK(rep.iterations > 0);
+        BOOST_CHECK(rep.residual_reduction <= tol);
+        // Some slack for the rounding of the recursively updated residuals.
+        BOOST_CHECK_SMALL((b - op.A * x).norm() / b.norm(), 10 * tol);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( krylovSymmetricPositiveDefinite ) {
+    const int n = 40;
+    const DenseOperator op = laplacian(n);
+    const Eigen::VectorXd b = rightHandSide(n);
+    const NoPreconditioner none = { n };
+    const JacobiPreconditioner jacobi = { op.A.diagonal() };
+    const double tol = 1e-10;
+
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+    checkSolution(cg(op, none, b, x, tol, 1000), op, b, x, tol);
+    x.setZero();
+    checkSolution(cg(op, jacobi, b, x, tol, 1000), op, b, x, tol);
+    x.setZero();
+    checkSolution(bicgstab(op, jacobi, b, x, tol, 1000), op, b, x, tol);
+    x.setZero();
+    checkSolution(gmres(op, jacobi, b, x, tol, 1000, 10), op, b, x, tol);
+}
+
+
+BOOST_AUTO_TEST_CASE( krylovNonsymmetric ) {
+    const int n = 40;
+    const DenseOperator op = convectionDiffusion(n);
+    const Eigen::VectorXd b = rightHandSide(n);
+    const NoPreconditioner none = { n };
+    const JacobiPreconditioner jacobi = { op.A.diagonal() };
+    const double tol = 1e-10;
+
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+    checkSolution(bicgstab(op, none, b, x, tol, 1000), op, b, x, tol);
+    x.setZero();
+    checkSolution(bicgstab(op, jacobi, b, x, tol, 1000), op, b, x, tol);
+    x.setZero();
+    checkSolution(gmres(op, none, b, x, tol, 1000, 5), op, b, x, tol);
+    x.setZero();
+    checkSolution(gmres(op, jacobi, b, x, tol, 1000, 50), op, b, x, tol);
+}
+
+
+BOOST_AUTO_TEST_CASE( krylovInitialGuessAndZeroRhs ) {
+    const int n = 10;
+    const DenseOperator op = convectionDiffusion(n);
+    const NoPreconditioner none = { n };
+
+    // An exact initial guess needs no iterations.
+    Eigen::VectorXd x = Eigen::VectorXd::Ones(n);
+    const Eigen::VectorXd b = op.A * x;
+    KrylovReport rep = gmres(op, none, b, x, 1e-10, 100, 10);
+    BOOST_CHECK(rep.converged);
+    BOOST_CHECK_EQUAL(rep.iterations, 0);
+
+    const Eigen::VectorXd zero = Eigen::VectorXd::Zero(n);
+    rep = bicgstab(op, none, zero, x, 1e-10, 100);
+    BOOST_CHECK(rep.converged);
+    BOOST_CHECK_EQUAL(x.norm(), 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE( gmresBreakdown ) {
+    // A nilpotent matrix: the Krylov space of b = e1 is {e1, e0}, and
+    // A e0 = 0, so the second step breaks down.
+    DenseOperator op = { Eigen::MatrixXd::Zero(2, 2) };
+    op.A(0, 1) = 1.0;
+    Eigen::VectorXd b(2);
+    b << 0.0, 1.0;
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(2);
+    const NoPreconditioner none = { 2 };
+    const KrylovReport rep = gmres(op, none, b, x, 1e-10, 100, 10);
+    BOOST_CHECK(!rep.converged);
+    BOOST_CHECK(std::isfinite(rep.residual_reduction));
+    BOOST_CHECK(std::isfinite(x[0]) && std::isfinite(x[1]));
+    BOOST_CHECK(rep.iterations < 100);
+}
+
+
+BOOST_AUTO_TEST_CASE( bicgstabShadowResidualBreakdown ) {
+    // A = I + N with N the lower shift and b = e0. The first residual is
+    // r1 = (e2 - e1) / 2, which is orthogonal to the shadow residual e0,
+    // so BiCGStab must restart to converge.
+    const int n = 8;
+    DenseOperator op = { Eigen::MatrixXd::Identity(n, n) };
+    for (int i = 1; i < n; ++i) {
+        op.A(i, i - 1) = 1.0;
+    }
+    Eigen::VectorXd b = Eigen::VectorXd::Zero(n);
+    b[0] = 1.0;
+    const NoPreconditioner none = { n };
+    const double tol = 1e-10;
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+    checkSolution(bicgstab(op, none, b, x, tol, 100), op, b, x, tol);
+
+    // Breakdown in the first step: r0 is orthogonal to A r0, and a
+    // restart cannot help. The solver stops with finite values.
+    DenseOperator indefinite = { Eigen::MatrixXd::Zero(2, 2) };
+    indefinite.A(0, 0) = 1.0;
+    indefinite.A(1, 1) = -1.0;
+    const Eigen::VectorXd ones = Eigen::VectorXd::Ones(2);
+    x.setZero(2);
+    const NoPreconditioner none2 = { 2 };
+    const KrylovReport rep = bicgstab(indefinite, none2, ones, x, tol, 100);
+    BOOST_CHECK(!rep.converged);
+    BOOST_CHECK(std::isfinite(rep.residual_reduction));
+    BOOST_CHECK_EQUAL(rep.iterations, 1);
+}
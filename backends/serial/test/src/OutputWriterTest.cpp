@@ -0,0 +1,216 @@
+#define BOOST_TEST_NO_MAIN
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <opm/grid/GridManager.hpp>
+#ifdef EQUELLE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "equelle/OutputWriter.hpp"
+
+using namespace equelle;
+
+namespace
+{
+    struct StoredRecord
+    {
+        std::string tag;
+        int step;
+        std::uint64_t offset;
+        std::vector<double> values;
+    };
+
+    template <typename T>
+    T readValue(std::istream& is)
+    {
+        T value;
+        is.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    }
+
+    /// Reads all records of a container, as documented in OutputWriter.hpp.
+    std::vector<StoredRecord> readContainer(const std::string& filename)
+    {
+        std::ifstream is(filename.c_str(), std::ios::binary);
+        BOOST_REQUIRE_MESSAGE(is, "Cannot open " << filename);
+        char magic[8];
+        is.read(magic, sizeof(magic));
+        BOOST_REQUIRE(std::memcmp(magic, "EQLOUTPT", sizeof(magic)) == 0);
+        BOOST_REQUIRE_EQUAL(readValue<std::uint32_t>(is), 1u);
+        const std::uint32_t compression = readValue<std::uint32_t>(is);
+        std::vector<StoredRecord> records;
+        for (;;) {
+            StoredRecord r;
+            r.offset = is.tellg();
+            r.step = readValue<std::uint32_t>(is);
+            if (!is) {
+                break;
+            }
+            const std::uint32_t tag_length = readValue<std::uint32_t>(is);
+            const std::uint64_t count = readValue<std::uint64_t>(is);
+            const std::uint64_t stored_bytes = readValue<std::uint64_t>(is);
+            std::vector<char> tag((tag_length + 7) / 8 * 8);
+            is.read(tag.data(), tag.size());
+            r.tag.assign(tag.data(), tag_length);
+            std::vector<char> data(stored_bytes);
+            is.read(data.data(), data.size());
+            BOOST_REQUIRE(is);
+            r.values.resize(count);
+            if (compression == 0) {
+                BOOST_REQUIRE_EQUAL(stored_bytes, count * sizeof(double));
+                std::memcpy(r.values.data(), data.data(), stored_bytes);
+            } else {
+#ifdef EQUELLE_HAVE_ZLIB
+                uLongf size = count * sizeof(double);
+                BOOST_REQUIRE_EQUAL(uncompress(reinterpret_cast<Bytef*>(r.values.data()), &size,
+                                               reinterpret_cast<const Bytef*>(data.data()), data.size()), Z_OK);
+                BOOST_REQUIRE_EQUAL(size, count * sizeof(double));
+#else
+                BOOST_FAIL("Compressed container without zlib.");
+#endif
+            }
+            records.push_back(r);
+        }
+        return records;
+    }
+
+    /// The lines of the index of a container.
+    std::vector<std::string> readIndex(const std::string& filename)
+    {
+        std::ifstream is((filename + ".index").c_str());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(is, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    std::string indexLine(const StoredRecord& r)
+    {
+        std::ostringstream os;
+        os << r.tag << ' ' << r.step << ' ' << r.offset << ' ' << r.values.size();
+        return os.str();
+    }
+
+    std::vector<double> someValues(const int n, const double start)
+    {
+        std::vector<double> values(n);
+        for (int i = 0; i < n; ++i) {
+            values[i] = start + 0.25 * i;
+        }
+        return values;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( binaryContainerRoundTrip ) {
+    Opm::ParameterGroup param;
+    param.insertParameter("output_format", "binary");
+    Opm::GridManager gm(3, 2, 1.0, 1.0);
+
+    const std::vector<double> a0 = someValues(6, 1.0);
+    const std::vector<double> a1 = someValues(6, -3.0);
+    const std::vector<double> b0 = someValues(1, 7.0);
+    {
+        OutputWriter writer(param, *gm.c_grid());
+        int step = writer.nextStep("binA");
+        BOOST_REQUIRE_EQUAL(step, 0);
+        writer.write("binA", step, a0.data(), a0.size());
+        step = writer.nextStep("binLongTagName");
+        writer.write("binLongTagName", step, b0.data(), b0.size());
+        step = writer.nextStep("binA");
+        BOOST_REQUIRE_EQUAL(step, 1);
+        writer.write("binA", step, a1.data(), a1.size());
+        writer.flush();
+    }
+
+    const std::vector<StoredRecord> a = readContainer("binA.eqo");
+    BOOST_REQUIRE_EQUAL(a.size(), 2u);
+    BOOST_CHECK_EQUAL(a[0].tag, "binA");
+    BOOST_CHECK_EQUAL(a[0].step, 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(a[0].values.begin(), a[0].values.end(), a0.begin(), a0.end());
+    BOOST_CHECK_EQUAL(a[1].step, 1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(a[1].values.begin(), a[1].values.end(), a1.begin(), a1.end());
+    const std::vector<std::string> index = readIndex("binA.eqo");
+    BOOST_REQUIRE_EQUAL(index.size(), 2u);
+    BOOST_CHECK_EQUAL(index[0], indexLine(a[0]));
+    BOOST_CHECK_EQUAL(index[1], indexLine(a[1]));
+
+    const std::vector<StoredRecord> b = readContainer("binLongTagName.eqo");
+    BOOST_REQUIRE_EQUAL(b.size(), 1u);
+    BOOST_CHECK_EQUAL(b[0].tag, "binLongTagName");
+    BOOST_CHECK_EQUAL_COLLECTIONS(b[0].values.begin(), b[0].values.end(), b0.begin(), b0.end());
+}
+
+
+BOOST_AUTO_TEST_CASE( asyncRunContainerRoundTrip ) {
+    Opm::ParameterGroup param;
+#ifdef EQUELLE_HAVE_ZLIB
+    param.insertParameter("output_format", "compressed");
+#else
+    param.insertParameter("output_format", "binary");
+#endif
+    param.insertParameter("output_container", "run");
+    param.insertParameter("output_async", "true");
+    param.insertParameter("output_queue_size", "2");
+    Opm::GridManager gm(3, 2, 1.0, 1.0);
+
+    const int num_steps = 10;
+    {
+        OutputWriter writer(param, *gm.c_grid());
+        for (int s = 0; s < num_steps; ++s) {
+            const std::vector<double> p = someValues(6, s);
+            const std::vector<double> q = someValues(1000, -s);
+            writer.write("runP", writer.nextStep("runP"), p.data(), p.size());
+            writer.write("runQ", writer.nextStep("runQ"), q.data(), q.size());
+        }
+        // The destructor writes the queue and closes the container.
+    }
+
+    const std::vector<StoredRecord> records = readContainer("output.eqo");
+    BOOST_REQUIRE_EQUAL(records.size(), 2u * num_steps);
+    const std::vector<std::string> index = readIndex("output.eqo");
+    BOOST_REQUIRE_EQUAL(index.size(), records.size());
+    for (int s = 0; s < num_steps; ++s) {
+        const StoredRecord& p = records[2 * s];
+        const StoredRecord& q = records[2 * s + 1];
+        BOOST_CHECK_EQUAL(p.tag, "runP");
+        BOOST_CHECK_EQUAL(q.tag, "runQ");
+        BOOST_CHECK_EQUAL(p.step, s);
+        BOOST_CHECK_EQUAL(q.step, s);
+        const std::vector<double> p_expected = someValues(6, s);
+        const std::vector<double> q_expected = someValues(1000, -s);
+        BOOST_CHECK_EQUAL_COLLECTIONS(p.values.begin(), p.values.end(), p_expected.begin(), p_expected.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(q.values.begin(), q.values.end(), q_expected.begin(), q_expected.end());
+        BOOST_CHECK_EQUAL(index[2 * s], indexLine(p));
+        BOOST_CHECK_EQUAL(index[2 * s + 1], indexLine(q));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( outputSelection ) {
+    Opm::ParameterGroup param;
+    param.insertParameter("output_format", "binary");
+    param.insertParameter("output_tags", "selA, selB");
+    param.insertParameter("output_every", "2");
+    param.insertParameter("output_every_selB", "3");
+    Opm::GridManager gm(3, 2, 1.0, 1.0);
+    OutputWriter writer(param, *gm.c_grid());
+
+    const int expected_a[] = { 0, -1, 2, -1, 4, -1, 6 };
+    const int expected_b[] = { 0, -1, -1, 3, -1, -1, 6 };
+    for (int s = 0; s < 7; ++s) {
+        BOOST_CHECK_EQUAL(writer.nextStep("selA"), expected_a[s]);
+        BOOST_CHECK_EQUAL(writer.nextStep("selB"), expected_b[s]);
+        BOOST_CHECK_EQUAL(writer.nextStep("selC"), -1);
+    }
+}
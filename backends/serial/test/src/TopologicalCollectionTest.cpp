@@ -0,0 +1,52 @@
+#define BOOST_TEST_NO_MAIN
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "equelle/equelleTypes.hpp"
+
+using namespace equelle;
+
+
+BOOST_AUTO_TEST_CASE( collectionCopyOnWrite ) {
+    const std::vector<Cell> cells = { Cell(1), Cell(4), Cell(6) };
+    CollOfCell a(cells);
+    const CollOfCell b = a;
+    BOOST_CHECK_EQUAL(a.id(), b.id());
+
+    // Reading does not detach or renew the identity.
+    BOOST_CHECK_EQUAL(a[1].index, 4);
+    int sum = 0;
+    for (const Cell c : a) {
+        sum += c.index;
+    }
+    BOOST_CHECK_EQUAL(sum, 11);
+    BOOST_CHECK_EQUAL(a.id(), b.id());
+
+    // Writing does, and leaves the copy unchanged.
+    a.set(1, Cell(5));
+    BOOST_CHECK_EQUAL(a[1].index, 5);
+    BOOST_CHECK_EQUAL(b[1].index, 4);
+    BOOST_CHECK_NE(a.id(), b.id());
+    const std::uint64_t id = a.id();
+    a.push_back(Cell(8));
+    BOOST_CHECK_EQUAL(a.size(), 4u);
+    BOOST_CHECK_EQUAL(b.size(), 3u);
+    BOOST_CHECK_NE(a.id(), id);
+}
+
+
+BOOST_AUTO_TEST_CASE( fullCollectionSet ) {
+    CollOfFace all = CollOfFace::full(4);
+    BOOST_CHECK(all.isFull());
+    BOOST_CHECK_EQUAL(all.id(), 0u);
+    BOOST_CHECK_EQUAL(all[2].index, 2);
+    all.set(2, Face(7));
+    BOOST_CHECK(!all.isFull());
+    BOOST_CHECK_NE(all.id(), 0u);
+    const int expected[] = { 0, 1, 7, 3 };
+    for (int i = 0; i < 4; ++i) {
+        BOOST_CHECK_EQUAL(all[i].index, expected[i]);
+    }
+}
@@ -0,0 +1,519 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#include "ADRequirementASTVisitor.hpp"
+#include "ASTNodes.hpp"
+#include "SymbolTable.hpp"
+#include <cctype>
+#include <cassert>
+
+
+ADRequirementASTVisitor::ADRequirementASTVisitor()
+    : sequence_depth_(0),
+      reference_suppression_level_(0),
+      newton_level_(0),
+      next_args_kind_(Transparent),
+      instantiating_node_(0),
+      next_instantiation_(-1)
+{
+}
+
+ADRequirementASTVisitor::~ADRequirementASTVisitor()
+{
+}
+
+std::string ADRequirementASTVisitor::instanceName(const std::string& function, const int instantiation)
+{
+    if (instantiation < 0) {
+        return function;
+    }
+    return function + "_i" + std::to_string(instantiation) + "_";
+}
+
+bool ADRequirementASTVisitor::needsAD(const VarAssignNode& node, const std::string& instance) const
+{
+    auto it = assignment_keys_.find(std::make_pair(&node, instance));
+    return it != assignment_keys_.end() && needs_ad_.count(it->second);
+}
+
+bool ADRequirementASTVisitor::argumentNeedsAD(const std::string& instance, const int arg) const
+{
+    auto it = argument_keys_.find(instance);
+    if (it == argument_keys_.end() || arg >= int(it->second.size())) {
+        return false;
+    }
+    return needs_ad_.count(it->second[arg]);
+}
+
+bool ADRequirementASTVisitor::returnNeedsAD(const std::string& instance) const
+{
+    return needs_ad_.count(returnKey(instance));
+}
+
+
+
+
+void ADRequirementASTVisitor::visit(SequenceNode&)
+{
+    if (sequence_depth_ == 0) {
+        // This is the root node of the program.
+        scopes_.push_back(Scope());
+    }
+    ++sequence_depth_;
+}
+
+void ADRequirementASTVisitor::midVisit(SequenceNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(SequenceNode&)
+{
+    --sequence_depth_;
+    if (sequence_depth_ == 0) {
+        // We are back at the root node, all flows are known.
+        scopes_.pop_back();
+        propagate();
+    }
+}
+
+void ADRequirementASTVisitor::visit(NumberNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(StringNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(TypeNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(FuncTypeNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(BinaryOpNode&)
+{
+}
+
+void ADRequirementASTVisitor::midVisit(BinaryOpNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(BinaryOpNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(ComparisonOpNode&)
+{
+    // Comparisons produce booleans, which never carry derivatives.
+    pushFrame(Discarded, "");
+}
+
+void ADRequirementASTVisitor::midVisit(ComparisonOpNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(ComparisonOpNode&)
+{
+    popFrame();
+}
+
+void ADRequirementASTVisitor::visit(NormNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(NormNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(UnaryNegationNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(UnaryNegationNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(OnNode&)
+{
+}
+
+void ADRequirementASTVisitor::midVisit(OnNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(OnNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(TrinaryIfNode&)
+{
+}
+
+void ADRequirementASTVisitor::questionMarkVisit(TrinaryIfNode&)
+{
+}
+
+void ADRequirementASTVisitor::colonVisit(TrinaryIfNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(TrinaryIfNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(VarDeclNode& node)
+{
+    if (reference_suppression_level_ == 0) {
+        declare(node.name());
+    }
+    // The declared type may contain expressions, they are not values.
+    ++reference_suppression_level_;
+}
+
+void ADRequirementASTVisitor::postVisit(VarDeclNode&)
+{
+    --reference_suppression_level_;
+}
+
+void ADRequirementASTVisitor::visit(VarAssignNode& node)
+{
+    std::string key = variableKey(node.name());
+    if (key.empty()) {
+        declare(node.name());
+        key = variableKey(node.name());
+    }
+    assignment_keys_[std::make_pair(&node, currentInstance())] = key;
+    pushFrame(Target, key);
+}
+
+void ADRequirementASTVisitor::postVisit(VarAssignNode&)
+{
+    popFrame();
+}
+
+void ADRequirementASTVisitor::visit(VarNode& node)
+{
+    if (reference_suppression_level_ > 0) {
+        return;
+    }
+    if (SymbolTable::isFunctionDeclared(node.name())) {
+        if (newton_level_ > 0) {
+            residuals_.insert(instanceName(node.name(), node.instantiationIndex()));
+        }
+        return;
+    }
+    const std::string key = variableKey(node.name());
+    if (!key.empty()) {
+        addFlow(key, currentTarget());
+    }
+}
+
+void ADRequirementASTVisitor::visit(FuncRefNode& node)
+{
+    if (reference_suppression_level_ == 0 && newton_level_ > 0) {
+        residuals_.insert(node.name());
+    }
+}
+
+void ADRequirementASTVisitor::visit(JustAnIdentifierNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(FuncArgsDeclNode&)
+{
+}
+
+void ADRequirementASTVisitor::midVisit(FuncArgsDeclNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(FuncArgsDeclNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(FuncDeclNode&)
+{
+    // The argument declarations belong to the function, not to this scope.
+    ++reference_suppression_level_;
+}
+
+void ADRequirementASTVisitor::postVisit(FuncDeclNode&)
+{
+    --reference_suppression_level_;
+}
+
+void ADRequirementASTVisitor::visit(FuncStartNode&)
+{
+    // The argument list only names the arguments.
+    ++reference_suppression_level_;
+    next_args_kind_ = Transparent;
+}
+
+void ADRequirementASTVisitor::postVisit(FuncStartNode&)
+{
+    --reference_suppression_level_;
+}
+
+void ADRequirementASTVisitor::visit(FuncAssignNode& node)
+{
+    const std::string& name = node.name();
+    const Function& f = SymbolTable::getFunction(name);
+    const std::vector<int> insta = f.instantiations();
+    int instantiation = -1;
+    if (instantiating_node_ == &node) {
+        instantiation = next_instantiation_;
+    } else if (!insta.empty()) {
+        // All but the last instantiation are done through accept()
+        // below, the last one follows the regular visitor flow.
+        const FuncAssignNode* outer_node = instantiating_node_;
+        const int outer_instantiation = next_instantiation_;
+        instantiating_node_ = &node;
+        for (size_t inst = 0; inst < insta.size() - 1; ++inst) {
+            next_instantiation_ = insta[inst];
+            node.accept(*this);
+        }
+        instantiating_node_ = outer_node;
+        next_instantiation_ = outer_instantiation;
+        instantiation = insta.back();
+    }
+    const std::string instance = instanceName(name, instantiation);
+    Scope scope;
+    scope.name = instance;
+    std::vector<std::string>& keys = argument_keys_[instance];
+    keys.clear();
+    for (const Variable& arg : f.functionType().arguments()) {
+        scope.variables.insert(arg.name());
+        keys.push_back(instance + "::" + arg.name());
+    }
+    scopes_.push_back(scope);
+    instances_.push_back(instance);
+}
+
+void ADRequirementASTVisitor::postVisit(FuncAssignNode&)
+{
+    instances_.pop_back();
+    scopes_.pop_back();
+}
+
+void ADRequirementASTVisitor::visit(FuncArgsNode&)
+{
+    pushFrame(next_args_kind_, next_args_function_);
+    next_args_kind_ = Transparent;
+}
+
+void ADRequirementASTVisitor::midVisit(FuncArgsNode&)
+{
+    ++frames_.back().arg;
+}
+
+void ADRequirementASTVisitor::postVisit(FuncArgsNode&)
+{
+    popFrame();
+}
+
+void ADRequirementASTVisitor::visit(ReturnStatementNode&)
+{
+    assert(!instances_.empty());
+    pushFrame(Target, returnKey(instances_.back()));
+}
+
+void ADRequirementASTVisitor::postVisit(ReturnStatementNode&)
+{
+    popFrame();
+}
+
+void ADRequirementASTVisitor::visit(FuncCallNode& node)
+{
+    const std::string& name = node.name();
+    if (name == "NewtonSolve" || name == "NewtonSolveSystem") {
+        // The solution is returned without derivatives, and the
+        // initial guesses are only used for their values.
+        ++newton_level_;
+        next_args_kind_ = Discarded;
+    } else if (reference_suppression_level_ == 0 && isUserFunction(name)) {
+        const std::string instance = instanceName(name, node.instantiationIndex());
+        addFlow(returnKey(instance), currentTarget());
+        next_args_kind_ = Argument;
+        next_args_function_ = instance;
+    } else {
+        next_args_kind_ = Transparent;
+    }
+}
+
+void ADRequirementASTVisitor::postVisit(FuncCallNode& node)
+{
+    if (node.name() == "NewtonSolve" || node.name() == "NewtonSolveSystem") {
+        --newton_level_;
+    }
+}
+
+void ADRequirementASTVisitor::visit(FuncCallStatementNode&)
+{
+    pushFrame(Discarded, "");
+}
+
+void ADRequirementASTVisitor::postVisit(FuncCallStatementNode&)
+{
+    popFrame();
+}
+
+void ADRequirementASTVisitor::visit(LoopNode& node)
+{
+    Scope scope;
+    scope.name = node.loopName();
+    scope.variables.insert(node.loopVariable());
+    scopes_.push_back(scope);
+}
+
+void ADRequirementASTVisitor::postVisit(LoopNode&)
+{
+    scopes_.pop_back();
+}
+
+void ADRequirementASTVisitor::visit(ArrayNode&)
+{
+    next_args_kind_ = Transparent;
+}
+
+void ADRequirementASTVisitor::postVisit(ArrayNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(RandomAccessNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(RandomAccessNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(StencilAssignmentNode&)
+{
+}
+
+void ADRequirementASTVisitor::midVisit(StencilAssignmentNode&)
+{
+}
+
+void ADRequirementASTVisitor::postVisit(StencilAssignmentNode&)
+{
+}
+
+void ADRequirementASTVisitor::visit(StencilNode&)
+{
+    next_args_kind_ = Transparent;
+}
+
+void ADRequirementASTVisitor::postVisit(StencilNode&)
+{
+}
+
+
+
+
+void ADRequirementASTVisitor::pushFrame(const FrameKind kind, const std::string& target)
+{
+    Frame frame;
+    frame.kind = kind;
+    frame.target = target;
+    frame.arg = 0;
+    frames_.push_back(frame);
+}
+
+void ADRequirementASTVisitor::popFrame()
+{
+    assert(!frames_.empty());
+    frames_.pop_back();
+}
+
+/// The key of the value that the expression being visited flows into,
+/// or an empty string if it does not flow anywhere.
+std::string ADRequirementASTVisitor::currentTarget() const
+{
+    for (auto it = frames_.rbegin(); it != frames_.rend(); ++it) {
+        switch (it->kind) {
+        case Transparent:
+            break;
+        case Target:
+            return it->target;
+        case Argument: {
+            auto ait = argument_keys_.find(it->target);
+            if (ait == argument_keys_.end() || it->arg >= int(ait->second.size())) {
+                return "";
+            }
+            return ait->second[it->arg];
+        }
+        case Discarded:
+            return "";
+        }
+    }
+    return "";
+}
+
+void ADRequirementASTVisitor::addFlow(const std::string& from, const std::string& to)
+{
+    if (!to.empty() && from != to) {
+        flows_[from].insert(to);
+    }
+}
+
+void ADRequirementASTVisitor::declare(const std::string& name)
+{
+    assert(!scopes_.empty());
+    scopes_.back().variables.insert(name);
+}
+
+/// The key of the variable with the given name as seen from the
+/// current scope, or an empty string if it is not declared.
+std::string ADRequirementASTVisitor::variableKey(const std::string& name) const
+{
+    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+        if (it->variables.count(name)) {
+            return it->name + "::" + name;
+        }
+    }
+    return "";
+}
+
+std::string ADRequirementASTVisitor::currentInstance() const
+{
+    return instances_.empty() ? std::string() : instances_.back();
+}
+
+std::string ADRequirementASTVisitor::returnKey(const std::string& instance)
+{
+    return instance + "::->";
+}
+
+bool ADRequirementASTVisitor::isUserFunction(const std::string& name)
+{
+    return SymbolTable::isFunctionDeclared(name) && !std::isupper(name[0]);
+}
+
+/// Mark everything reachable from the residual functions as needing AD.
+void ADRequirementASTVisitor::propagate()
+{
+    std::vector<std::string> pending;
+    for (const std::string& residual : residuals_) {
+        // A residual is called with AD arguments and must return
+        // its derivatives.
+        pending.push_back(returnKey(residual));
+        for (const std::string& arg : argument_keys_[residual]) {
+            pending.push_back(arg);
+        }
+    }
+    while (!pending.empty()) {
+        const std::string key = pending.back();
+        pending.pop_back();
+        if (!needs_ad_.insert(key).second) {
+            continue;
+        }
+        auto it = flows_.find(key);
+        if (it != flows_.end()) {
+            pending.insert(pending.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
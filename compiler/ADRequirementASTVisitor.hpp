@@ -0,0 +1,158 @@
+/*
+  Copyright 2014 SINTEF ICT, Applied Mathematics.
+*/
+
+#ifndef ADREQUIREMENTASTVISITOR_HEADER_INCLUDED
+#define ADREQUIREMENTASTVISITOR_HEADER_INCLUDED
+
+#include "ASTVisitorInterface.hpp"
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <utility>
+
+/// Data-flow analysis finding the variables and functions that need
+/// automatic differentiation (AD) types.
+///
+/// Derivatives are only created by NewtonSolve() and NewtonSolveSystem(),
+/// which call their residual functions with AD arguments. The visitor
+/// builds a graph of which variables, function arguments and function
+/// return values each value flows into, and marks everything reachable
+/// from the residual function arguments. All other values can use
+/// value-only types. Each instantiation of a function template is
+/// analysed separately, so that only the instantiations called with AD
+/// arguments get AD types. Results are valid after the program has been
+/// visited, which must be done after the CheckASTVisitor pass.
+class ADRequirementASTVisitor : public ASTVisitorInterface
+{
+public:
+    ADRequirementASTVisitor();
+    virtual ~ADRequirementASTVisitor();
+
+    void visit(SequenceNode& node);
+    void midVisit(SequenceNode& node);
+    void postVisit(SequenceNode& node);
+    void visit(NumberNode& node);
+    void visit(StringNode& node);
+    void visit(TypeNode& node);
+    void visit(FuncTypeNode& node);
+    void visit(BinaryOpNode& node);
+    void midVisit(BinaryOpNode& node);
+    void postVisit(BinaryOpNode& node);
+    void visit(ComparisonOpNode& node);
+    void midVisit(ComparisonOpNode& node);
+    void postVisit(ComparisonOpNode& node);
+    void visit(NormNode& node);
+    void postVisit(NormNode& node);
+    void visit(UnaryNegationNode& node);
+    void postVisit(UnaryNegationNode& node);
+    void visit(OnNode& node);
+    void midVisit(OnNode& node);
+    void postVisit(OnNode& node);
+    void visit(TrinaryIfNode& node);
+    void questionMarkVisit(TrinaryIfNode& node);
+    void colonVisit(TrinaryIfNode& node);
+    void postVisit(TrinaryIfNode& node);
+    void visit(VarDeclNode& node);
+    void postVisit(VarDeclNode& node);
+    void visit(VarAssignNode& node);
+    void postVisit(VarAssignNode& node);
+    void visit(VarNode& node);
+    void visit(FuncRefNode& node);
+    void visit(JustAnIdentifierNode& node);
+    void visit(FuncArgsDeclNode& node);
+    void midVisit(FuncArgsDeclNode& node);
+    void postVisit(FuncArgsDeclNode& node);
+    void visit(FuncDeclNode& node);
+    void postVisit(FuncDeclNode& node);
+    void visit(FuncStartNode& node);
+    void postVisit(FuncStartNode& node);
+    void visit(FuncAssignNode& node);
+    void postVisit(FuncAssignNode& node);
+    void visit(FuncArgsNode& node);
+    void midVisit(FuncArgsNode& node);
+    void postVisit(FuncArgsNode& node);
+    void visit(ReturnStatementNode& node);
+    void postVisit(ReturnStatementNode& node);
+    void visit(FuncCallNode& node);
+    void postVisit(FuncCallNode& node);
+    void visit(FuncCallStatementNode& node);
+    void postVisit(FuncCallStatementNode& node);
+    void visit(LoopNode& node);
+    void postVisit(LoopNode& node);
+    void visit(ArrayNode& node);
+    void postVisit(ArrayNode& node);
+    void visit(RandomAccessNode& node);
+    void postVisit(RandomAccessNode& node);
+    void visit(StencilAssignmentNode& node);
+    void midVisit(StencilAssignmentNode& node);
+    void postVisit(StencilAssignmentNode& node);
+    void visit(StencilNode& node);
+    void postVisit(StencilNode& node);
+
+    /// The name identifying a function, or one instantiation of a
+    /// function template, in the queries below. Use instantiation -1
+    /// for functions that are not templates.
+    static std::string instanceName(const std::string& function, const int instantiation);
+
+    /// True if the variable assigned by the node needs AD types. The
+    /// instance is the innermost enclosing function instance, or an
+    /// empty string outside of functions.
+    bool needsAD(const VarAssignNode& node, const std::string& instance) const;
+
+    /// True if argument number arg of the function instance needs AD types.
+    bool argumentNeedsAD(const std::string& instance, const int arg) const;
+
+    /// True if the return value of the function instance needs AD types.
+    bool returnNeedsAD(const std::string& instance) const;
+
+private:
+    // How values found inside an expression flow.
+    enum FrameKind {
+        Transparent, // to the enclosing frame
+        Target,      // into the frame's target
+        Argument,    // into the current argument of a user function
+        Discarded    // nowhere that needs derivatives
+    };
+    struct Frame
+    {
+        FrameKind kind;
+        std::string target;
+        int arg;
+    };
+    struct Scope
+    {
+        std::string name;
+        std::set<std::string> variables;
+    };
+
+    int sequence_depth_;
+    int reference_suppression_level_;
+    int newton_level_;
+    FrameKind next_args_kind_;
+    std::string next_args_function_;
+    std::vector<Frame> frames_;
+    std::vector<Scope> scopes_;
+    const FuncAssignNode* instantiating_node_;
+    int next_instantiation_;
+    std::vector<std::string> instances_;
+    std::map<std::string, std::vector<std::string> > argument_keys_;
+    std::map<std::pair<const VarAssignNode*, std::string>, std::string> assignment_keys_;
+    std::map<std::string, std::set<std::string> > flows_;
+    std::set<std::string> residuals_;
+    std::set<std::string> needs_ad_;
+
+    void pushFrame(const FrameKind kind, const std::string& target);
+    void popFrame();
+    std::string currentTarget() const;
+    void addFlow(const std::string& from, const std::string& to);
+    void declare(const std::string& name);
+    std::string variableKey(const std::string& name) const;
+    std::string currentInstance() const;
+    static std::string returnKey(const std::string& instance);
+    static bool isUserFunction(const std::string& name);
+    void propagate();
+};
+
+#endif // ADREQUIREMENTASTVISITOR_HEADER_INCLUDED
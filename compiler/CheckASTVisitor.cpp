@@ -744,9 +744,12 @@ void CheckASTVisitor::visit(FuncCallNode& node)
         ArrayNode& func_array = dynamic_cast<ArrayNode&>(*argnodes[0]);
         ArrayNode& guess_array = dynamic_cast<ArrayNode&>(*argnodes[1]);
         const auto& funcs = func_array.expressionList()->arguments();
-        assert(funcs.size() == 2);
         const auto& guesses = guess_array.expressionList()->arguments();
-        assert(guesses.size() == 2);
+        if (funcs.size() != guesses.size()) {
+            error("NewtonSolveSystem needs as many residual functions as initial guesses", node.location());
+            return;
+        }
+        const int num = guesses.size();
         for (ExpressionNode* fnode : funcs) {
             VarNode& vn = dynamic_cast<VarNode&>(*fnode);
             const std::string& func_name = vn.name();
@@ -754,8 +757,11 @@ void CheckASTVisitor::visit(FuncCallNode& node)
             if (f.isTemplate()) {
                 // Must instantiate function.
                 std::vector<Variable> fargs = f.functionType().arguments();
-                assert(fargs.size() == 2);
-                for (int ia = 0; ia < 2; ++ia) {
+                if (int(fargs.size()) != num) {
+                    error("residual functions of NewtonSolveSystem must take one argument per unknown", node.location());
+                    return;
+                }
+                for (int ia = 0; ia < num; ++ia) {
                     fargs[ia].setType(guesses[ia]->type());
                     fargs[ia].setAssigned(true);
                     if (!ignore_dimension_) {
@@ -29,6 +29,7 @@ public:
             ("input,i", boost::program_options::value<std::string>()->required(), "Input Equelle file to compile")
             ("backend", boost::program_options::value<std::string>()->default_value("cpu"), "Backend of compiler to use (io, ast, ast_equelle, cpu*, cuda, mrst)")
             ("nondimensional", "Disable dimension checking")
+            ("ad_types", "Use automatic differentiation types for all collections (cpu backend)")
             ("dump", boost::program_options::value<std::string>()->default_value("none"), "Dump compiler internals (symboltable, io)");
     }
 
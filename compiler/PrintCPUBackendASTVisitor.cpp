@@ -3,6 +3,7 @@
 */
 
 #include "PrintCPUBackendASTVisitor.hpp"
+#include "ADRequirementASTVisitor.hpp"
 #include "ASTNodes.hpp"
 #include "SymbolTable.hpp"
 #include <iostream>
@@ -24,17 +25,24 @@ PrintCPUBackendASTVisitor::PrintCPUBackendASTVisitor()
       sequence_depth_(0),
       instantiating_(false),
       next_funcstart_inst_(-1),
-      use_cartesian_(false)
+      use_cartesian_(false),
+      ad_requirements_(0),
+      target_needs_ad_(true),
+      num_newton_sites_(0)
 {
 }
 
-PrintCPUBackendASTVisitor::PrintCPUBackendASTVisitor(const bool use_cartesian)
+PrintCPUBackendASTVisitor::PrintCPUBackendASTVisitor(const bool use_cartesian,
+                                                     const ADRequirementASTVisitor* ad_requirements)
     : suppression_level_(0),
       indent_(1),
       sequence_depth_(0),
       instantiating_(false),
       next_funcstart_inst_(-1),
-      use_cartesian_(use_cartesian)
+      use_cartesian_(use_cartesian),
+      ad_requirements_(ad_requirements),
+      target_needs_ad_(true),
+      num_newton_sites_(0)
 {
 }
 
@@ -250,7 +258,13 @@ void PrintCPUBackendASTVisitor::visit(OnNode& node)
         return;
     }
     if (node.isExtend()) {
-        std::cout << "er.operatorExtend(";
+        // A Scalar extended to a set is a constant, that only needs
+        // derivatives if the value it is part of does.
+        if (!node.leftType().isCollection() && !target_needs_ad_) {
+            std::cout << "er.operatorExtendValue(";
+        } else {
+            std::cout << "er.operatorExtend(";
+        }
     } else {
         std::cout << "er.operatorOn(";
     }
@@ -342,14 +356,21 @@ void PrintCPUBackendASTVisitor::visit(VarAssignNode& node)
         //This goes into the stencil-lambda definition, and is only used during parsing.
         std::cout << "// Note: ";
     }
+    const std::string instance = function_instances_.empty() ? std::string() : function_instances_.back();
+    target_needs_ad_ = !ad_requirements_ || ad_requirements_->needsAD(node, instance);
     if (!SymbolTable::variableType(node.name()).isMutable()) {
 #if 0
         std::cout << "const auto ";
 #else
-        std::cout << "const " << cppTypeString(node.type()) << " ";
+        std::cout << "const " << cppTypeString(node.type(), target_needs_ad_) << " ";
 #endif
     } else if (defined_mutables_.count(node.name()) == 0) {
-        std::cout << "auto ";
+        if (ad_requirements_) {
+            // Eigen expression templates must not be captured by auto.
+            std::cout << cppTypeString(node.type(), target_needs_ad_) << " ";
+        } else {
+            std::cout << "auto ";
+        }
         defined_mutables_.insert(node.name());
     }
     std::cout << node.name() << " = ";
@@ -432,13 +453,16 @@ void PrintCPUBackendASTVisitor::visit(FuncStartNode& node)
     if (next_funcstart_inst_ != -1 && num_inst > 1) {
         std::cout << "_i" << next_funcstart_inst_ << "_";
     }
+    const std::string instance = ADRequirementASTVisitor::instanceName(node.name(), next_funcstart_inst_);
+    function_instances_.push_back(instance);
     std::cout << " = [&](";
     for (int i = 0; i < n; ++i) {
 #if 0
         std::cout << "const auto& " << ft.arguments()[i].name();
 #else
+        const bool needs_ad = !ad_requirements_ || ad_requirements_->argumentNeedsAD(instance, i);
         std::cout << "const "
-                  << cppTypeString(ft.arguments()[i].type())
+                  << cppTypeString(ft.arguments()[i].type(), needs_ad)
                   << "& " << ft.arguments()[i].name();
 #endif
         if (i < n - 1) {
@@ -460,7 +484,8 @@ void PrintCPUBackendASTVisitor::postVisit(FuncStartNode& node)
     std::cout << ") {";
 #else
     const FunctionType& ft = SymbolTable::getFunction(node.name()).functionType();
-    std::cout << ") -> " << cppTypeString(ft.returnType()) << " {";
+    const bool needs_ad = !ad_requirements_ || ad_requirements_->returnNeedsAD(function_instances_.back());
+    std::cout << ") -> " << cppTypeString(ft.returnType(), needs_ad) << " {";
 #endif
     endl();
 }
@@ -513,6 +538,7 @@ void PrintCPUBackendASTVisitor::postVisit(FuncAssignNode& node)
     --indent_;
     std::cout << indent() << "};";
     endl();
+    function_instances_.pop_back();
     SymbolTable::setCurrentFunction(SymbolTable::getCurrentFunction().parentScope());
 }
 
@@ -537,6 +563,7 @@ void PrintCPUBackendASTVisitor::visit(ReturnStatementNode&)
     if (isSuppressed()) {
         return;
     }
+    target_needs_ad_ = !ad_requirements_ || ad_requirements_->returnNeedsAD(function_instances_.back());
     std::cout << indent() << "return ";
 }
 
@@ -584,6 +611,9 @@ void PrintCPUBackendASTVisitor::visit(FuncCallNode& node)
             cppname += std::to_string(node.instantiationIndex());
             cppname += "_";
         }
+        if (fname == "NewtonSolve" || fname == "NewtonSolveSystem") {
+            newton_sites_.push_back(++num_newton_sites_);
+        }
         std::cout << cppname << '(';
     }
     else if (SymbolTable::isVariableDeclared(node.name()) && node.type().isStencil()) {
@@ -594,11 +624,17 @@ void PrintCPUBackendASTVisitor::visit(FuncCallNode& node)
     }
 }
 
-void PrintCPUBackendASTVisitor::postVisit(FuncCallNode&)
+void PrintCPUBackendASTVisitor::postVisit(FuncCallNode& node)
 {
     if (isSuppressed()) {
         return;
     }
+    if (SymbolTable::isFunctionDeclared(node.name())
+        && (node.name() == "NewtonSolve" || node.name() == "NewtonSolveSystem")) {
+        // The site selects the linear solver and its parameters.
+        std::cout << ", " << newton_sites_.back();
+        newton_sites_.pop_back();
+    }
     std::cout << ')';
 }
 
@@ -607,6 +643,7 @@ void PrintCPUBackendASTVisitor::visit(FuncCallStatementNode&)
     if (isSuppressed()) {
         return;
     }
+    target_needs_ad_ = !ad_requirements_;
     std::cout << indent();
 }
 
@@ -670,8 +707,9 @@ void PrintCPUBackendASTVisitor::visit(RandomAccessNode& node)
         // This is Array access.
         std::cout << "std::get<" << node.index() << ">(";
     } else {
-        // This is Vector access.
-        std::cout << "CollOfScalar(";
+        // This is Vector access. The column keeps its derivatives
+        // only if the value it is part of needs them.
+        std::cout << (target_needs_ad_ ? "CollOfScalar(" : "CollOfScalarValue(");
     }
 }
 
@@ -743,14 +781,14 @@ bool PrintCPUBackendASTVisitor::isSuppressed() const
     return suppression_level_ > 0;
 }
 
-std::string PrintCPUBackendASTVisitor::cppTypeString(const EquelleType& et) const
+std::string PrintCPUBackendASTVisitor::cppTypeString(const EquelleType& et, const bool needs_ad) const
 {
     std::string cppstring;
     if (et.isArray()) {
         cppstring += "std::tuple<";
         EquelleType basic_et = et;
         basic_et.setArraySize(NotAnArray);
-        std::string basiccppstring = cppTypeString(basic_et);
+        std::string basiccppstring = cppTypeString(basic_et, needs_ad);
         for (int elem = 0; elem < et.arraySize(); ++elem) {
             cppstring += basiccppstring;
             if (elem < et.arraySize() - 1) {
@@ -769,6 +807,10 @@ std::string PrintCPUBackendASTVisitor::cppTypeString(const EquelleType& et) cons
         cppstring += "SeqOf";
     }
     cppstring += basicTypeString(et.basicType());
+    if (!needs_ad && et.isCollection() && !et.isStencil() && et.basicType() == Scalar) {
+        // Collections that never need derivatives.
+        cppstring += "Value";
+    }
     return cppstring;
 }
 
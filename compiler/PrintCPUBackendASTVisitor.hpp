@@ -9,12 +9,18 @@
 #include "EquelleType.hpp"
 #include <string>
 #include <set>
+#include <vector>
+
+class ADRequirementASTVisitor;
 
 class PrintCPUBackendASTVisitor : public ASTVisitorInterface
 {
 public:
     PrintCPUBackendASTVisitor();
-    explicit PrintCPUBackendASTVisitor(const bool use_cartesian);
+    /// If ad_requirements is given, collections that do not need
+    /// automatic differentiation are given value-only types.
+    explicit PrintCPUBackendASTVisitor(const bool use_cartesian,
+                                       const ADRequirementASTVisitor* ad_requirements = 0);
     virtual ~PrintCPUBackendASTVisitor();
 
     void visit(SequenceNode& node);
@@ -96,13 +102,20 @@ private:
     int next_funcstart_inst_;
     std::string skipping_function_;
     bool use_cartesian_;
+    const ADRequirementASTVisitor* ad_requirements_;
+    bool target_needs_ad_;
+    std::vector<std::string> function_instances_;
+    // Call sites of NewtonSolve() and NewtonSolveSystem() are numbered
+    // 1, 2, ... in program order, and the number is passed to the runtime.
+    int num_newton_sites_;
+    std::vector<int> newton_sites_;
 
     void endl() const;
     std::string indent() const;
     void suppress();
     void unsuppress();
     bool isSuppressed() const;
-    std::string cppTypeString(const EquelleType& et) const;
+    std::string cppTypeString(const EquelleType& et, const bool needs_ad = true) const;
     void addRequirementString(const std::string& req);
 };
 
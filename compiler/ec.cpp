@@ -4,6 +4,7 @@
 
 #include "SymbolTable.hpp"
 #include "CheckASTVisitor.hpp"
+#include "ADRequirementASTVisitor.hpp"
 #include "PrintASTVisitor.hpp"
 #include "PrintEquelleASTVisitor.hpp"
 #include "PrintCPUBackendASTVisitor.hpp"
@@ -102,8 +103,17 @@ int main(int argc, char** argv)
         else if (backend == "cpu") {
             // Check if we use the Cartesian dialect
             const bool use_cartesian = cli_vars.count("cartesian");
-            PrintCPUBackendASTVisitor v(use_cartesian);
-            SymbolTable::program()->accept(v);
+            if (use_cartesian || cli_vars.count("ad_types")) {
+                PrintCPUBackendASTVisitor v(use_cartesian);
+                SymbolTable::program()->accept(v);
+            } else {
+                // Only values that can reach a NewtonSolve residual
+                // need automatic differentiation types.
+                ADRequirementASTVisitor ad;
+                SymbolTable::program()->accept(ad);
+                PrintCPUBackendASTVisitor v(use_cartesian, &ad);
+                SymbolTable::program()->accept(v);
+            }
         }
         else if (backend == "cuda") {
             PrintCUDABackendASTVisitor v;
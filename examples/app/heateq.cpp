@@ -52,7 +52,7 @@ int main(int argc, char** argv)
         return residual;
     };
     const CollOfScalar explicitu = (u0 - computeResidual(u0));
-    const CollOfScalar u = er.newtonSolve(computeResidual, u0);
+    const CollOfScalar u = er.newtonSolve(computeResidual, u0, 1);
     er.output("explicitu", explicitu);
     er.output("u", u);
 
@@ -55,7 +55,7 @@ int main(int argc, char** argv)
             return computeResidual(u, u0, dt);
         };
         const CollOfScalar u_guess = u0;
-        const CollOfScalar u = er.newtonSolve(computeResidualLocal, u_guess);
+        const CollOfScalar u = er.newtonSolve(computeResidualLocal, u_guess, 1);
         er.output("u", u);
         er.output("maximum of u", er.maxReduce(u));
         u0 = u;
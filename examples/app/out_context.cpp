@@ -25,7 +25,7 @@ void equelleGeneratedCode(equelle::EquelleRuntimeCPU& er) {
 
     // ============= Generated code starts here ================
 
-    auto a = double(8);
+    Scalar a = double(8);
     auto f_i0_ = [&]() -> Scalar {
         return (double(2) * a);
     };
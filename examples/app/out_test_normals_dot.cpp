@@ -26,16 +26,16 @@ void equelleGeneratedCode(equelle::EquelleRuntimeCPU& er) {
     // ============= Generated code starts here ================
 
     const CollOfVector n = er.normal(er.allFaces());
-    const CollOfScalar n2 = er.dot(n, n);
-    const CollOfScalar n0 = CollOfScalar(n.col(0));
-    const std::tuple<CollOfScalar, CollOfScalar> narray = makeArray(n0, (n0 + n2));
+    const CollOfScalarValue n2 = er.dot(n, n);
+    const CollOfScalarValue n0 = CollOfScalarValue(n.col(0));
+    const std::tuple<CollOfScalarValue, CollOfScalarValue> narray = makeArray(n0, (n0 + n2));
     er.output("squared normals", n2);
     er.output("first component", n0);
     er.output("their sum", std::get<1>(narray));
-    auto getsecond_i0_ = [&](const std::tuple<CollOfScalar, CollOfScalar>& a) -> CollOfScalar {
+    auto getsecond_i0_ = [&](const std::tuple<CollOfScalarValue, CollOfScalarValue>& a) -> CollOfScalarValue {
         return std::get<1>(a);
     };
-    auto getsecond_i1_ = [&](const std::tuple<CollOfScalar, CollOfScalar>& a) -> CollOfScalar {
+    auto getsecond_i1_ = [&](const std::tuple<CollOfScalarValue, CollOfScalarValue>& a) -> CollOfScalarValue {
         return std::get<1>(a);
     };
     er.output("second element of array", getsecond_i0_(narray));
@@ -25,13 +25,13 @@ void equelleGeneratedCode(equelle::EquelleRuntimeCPU& er) {
 
     // ============= Generated code starts here ================
 
-    const CollOfScalar a = CollOfScalar(er.centroid(er.allCells()).col(0));
-    const CollOfScalar b = CollOfScalar(er.centroid(er.allCells()).col(1));
-    er.output("hmmm", er.trinaryIf((a > er.operatorExtend(double(0), er.allCells())), (a + b), er.operatorExtend(double(0), er.allCells())));
-    const CollOfScalar a1 = er.operatorOn((a + b), er.allCells(), er.interiorCells());
-    const CollOfScalar b1 = er.operatorOn(b, er.allCells(), er.interiorCells());
-    const CollOfScalar c = er.operatorExtend((a1 + b1), er.interiorCells(), er.allCells());
-    const std::tuple<CollOfScalar, CollOfScalar, CollOfScalar> array = makeArray((a1 + b1), (a1 - b1), a1);
+    const CollOfScalarValue a = CollOfScalarValue(er.centroid(er.allCells()).col(0));
+    const CollOfScalarValue b = CollOfScalarValue(er.centroid(er.allCells()).col(1));
+    er.output("hmmm", er.trinaryIf((a > er.operatorExtendValue(double(0), er.allCells())), (a + b), er.operatorExtendValue(double(0), er.allCells())));
+    const CollOfScalarValue a1 = er.operatorOn((a + b), er.allCells(), er.interiorCells());
+    const CollOfScalarValue b1 = er.operatorOn(b, er.allCells(), er.interiorCells());
+    const CollOfScalarValue c = er.operatorExtend((a1 + b1), er.interiorCells(), er.allCells());
+    const std::tuple<CollOfScalarValue, CollOfScalarValue, CollOfScalarValue> array = makeArray((a1 + b1), (a1 - b1), a1);
     const String qww = "This is a string with \"quoted escapes\" and others \n\n\n such as newlines";
     er.output(qww, double(2));
 